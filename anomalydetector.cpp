@@ -0,0 +1,141 @@
+#include "anomalydetector.h"
+
+#include <cstring>
+
+namespace {
+
+const quint64 kMissingFactor = 5;     // Silence > 5x the mean period is missing
+const int kJumpThreshold = 64;        // Byte delta considered a sudden jump
+
+} // namespace
+
+// -------------------- EVENTS --------------------
+QString BusEvent::description() const
+{
+    const QString name = QString("0x%1").arg(id, 7, 16, QChar('0')).toUpper();
+    switch (kind) {
+    case ParseError:   return "Malformed line from bridge";
+    case Resync:       return "Stream resynchronised";
+    case LateFrame:    return QString("%1 late (%2 ms gap)").arg(name).arg(detail / 1000.0, 0, 'f', 1);
+    case MissingFrame: return QString("%1 missing (period %2 ms)").arg(name).arg(detail / 1000.0, 0, 'f', 1);
+    case DlcMismatch:  return QString("%1 DLC changed to %2").arg(name).arg(detail);
+    case SignalJump:   return QString("%1 byte %2 jumped").arg(name).arg(detail);
+    case KindCount:    break;
+    }
+    return QString();
+}
+
+BusEventLog::BusEventLog(int capacity)
+    : ring(capacity)
+    , head(0)
+    , count(0)
+{
+}
+
+void BusEventLog::append(const BusEvent &event)
+{
+    ring[head] = event;
+    head = (head + 1) % ring.size();
+    if (count < ring.size())
+        count++;
+}
+
+void BusEventLog::clear()
+{
+    head = 0;
+    count = 0;
+}
+
+const BusEvent &BusEventLog::at(int index) const
+{
+    return ring[(head - count + index + ring.size()) % ring.size()];
+}
+
+// -------------------- DETECTOR --------------------
+AnomalyDetector::AnomalyDetector()
+{
+    clear();
+}
+
+void AnomalyDetector::clear()
+{
+    ids.clear();
+    log.clear();
+    memset(counts, 0, sizeof(counts));
+    total = 0;
+    resyncPending = false;
+}
+
+void AnomalyDetector::raise(quint64 timestampNs, quint32 id, BusEvent::Kind kind, quint32 detail)
+{
+    BusEvent event;
+    event.timestampNs = timestampNs;
+    event.id = id;
+    event.kind = kind;
+    event.detail = detail;
+    log.append(event);
+    counts[kind]++;
+    total++;
+}
+
+void AnomalyDetector::onParseError(quint64 timestampNs)
+{
+    raise(timestampNs, 0, BusEvent::ParseError, 0);
+    resyncPending = true;
+}
+
+void AnomalyDetector::onFrame(const CanMessage &msg)
+{
+    if (resyncPending) {
+        raise(msg.timestampNs, msg.id, BusEvent::Resync, 0);
+        resyncPending = false;
+    }
+
+    IdState &state = ids[msg.id];
+    const bool first = state.stats.count == 0;
+    state.stats.id = msg.id;
+
+    // The gap after a MissingFrame was already reported; it is neither late
+    // nor a period, the outage would drag the mean up
+    if (state.missing) {
+        state.stats.lastNs = msg.timestampNs;
+        state.missing = false;
+    }
+
+    quint64 interval = 0;
+    const int findings = state.stats.add(msg.timestampNs, msg.dlc, IdStatistics::kDefaultLateFactor, &interval);
+    if (first) {
+        // First sighting: learn the payload
+        memcpy(state.data, msg.data, sizeof(state.data));
+        return;
+    }
+
+    if (findings & IdStatistics::Late)
+        raise(msg.timestampNs, msg.id, BusEvent::LateFrame, quint32(qMin<quint64>(interval / 1000, 0xFFFFFFFF)));
+    if (findings & IdStatistics::DlcChanged)
+        raise(msg.timestampNs, msg.id, BusEvent::DlcMismatch, msg.dlc);
+
+    // Signal jumps, modulo 256 so rolling counters wrapping are not flagged
+    for (int i = 0; i < msg.dlc; i++) {
+        int delta = (msg.data[i] - state.data[i]) & 0xFF;
+        if (qMin(delta, 256 - delta) > kJumpThreshold) {
+            raise(msg.timestampNs, msg.id, BusEvent::SignalJump, quint32(i));
+            break;
+        }
+    }
+    memcpy(state.data, msg.data, sizeof(state.data));
+}
+
+void AnomalyDetector::checkMissing(quint64 nowNs)
+{
+    for (auto it = ids.begin(); it != ids.end(); ++it) {
+        IdState &state = it.value();
+        const quint64 periodNs = state.stats.meanPeriodNs();
+        if (state.missing || state.stats.periods < IdStatistics::kMinPeriodsForLate || periodNs == 0)
+            continue;
+        if (nowNs > state.stats.lastNs && nowNs - state.stats.lastNs > kMissingFactor * periodNs) {
+            raise(nowNs, it.key(), BusEvent::MissingFrame, quint32(qMin<quint64>(periodNs / 1000, 0xFFFFFFFF)));
+            state.missing = true;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef ANOMALYDETECTOR_H
+#define ANOMALYDETECTOR_H
+
+#include "canmessage.h"
+#include "captureanalyzer.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+struct BusEvent {
+    enum Kind {
+        ParseError,     // Line from the bridge could not be decoded
+        Resync,         // First valid frame after garbage
+        LateFrame,      // Cyclic frame arrived well after its learned period
+        MissingFrame,   // Cyclic frame stopped arriving
+        DlcMismatch,    // DLC differs from the one learned for the ID
+        SignalJump,     // Payload byte changed by more than the jump threshold
+        KindCount
+    };
+
+    quint64 timestampNs = 0;
+    quint32 id = 0;
+    Kind kind = ParseError;
+    quint32 detail = 0;         // Period/gap in us, DLC, or byte index
+
+    QString description() const;
+};
+
+// Fixed-capacity ring of the most recent events; never allocates after
+// construction.
+class BusEventLog
+{
+public:
+    explicit BusEventLog(int capacity = 1024);
+
+    void append(const BusEvent &event);
+    void clear();
+
+    int size() const { return count; }
+    const BusEvent &at(int index) const; // 0 = oldest kept event
+
+private:
+    QVector<BusEvent> ring;
+    int head;
+    int count;
+};
+
+// Inline protocol and plausibility checks on the ingest path. Every frame
+// costs one hash lookup plus a fixed amount of arithmetic; periods and DLCs
+// are learned per ID from the traffic itself, with the same accumulator and
+// late/DLC rules as the offline analyzer (IdStatistics::add).
+class AnomalyDetector
+{
+public:
+    AnomalyDetector();
+
+    void onFrame(const CanMessage &msg);
+    void onParseError(quint64 timestampNs);
+
+    // Reports cyclic IDs that went silent, call periodically
+    void checkMissing(quint64 nowNs);
+
+    void clear();
+
+    quint64 totalEvents() const { return total; }
+    quint64 eventCount(BusEvent::Kind kind) const { return counts[kind]; }
+    const BusEventLog &events() const { return log; }
+
+private:
+    struct IdState {
+        IdStatistics stats;         // Timing and DLC, capture clock
+        quint8 data[8] = {};
+        bool missing = false;
+    };
+
+    void raise(quint64 timestampNs, quint32 id, BusEvent::Kind kind, quint32 detail);
+
+    QHash<quint32, IdState> ids;
+    BusEventLog log;
+    quint64 counts[BusEvent::KindCount];
+    quint64 total;
+    bool resyncPending;
+};
+
+#endif // ANOMALYDETECTOR_H
@@ -0,0 +1,197 @@
+#include "bridgeprotocol.h"
+
+#include <cstring>
+
+namespace {
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t';
+}
+
+bool isTerminator(char c)
+{
+    return c == '\n' || c == '\r';
+}
+
+void skipSpaces(const char *&p, const char *end)
+{
+    while (p < end && isSpace(*p))
+        p++;
+}
+
+} // namespace
+
+// -------------------- TX RECORDS --------------------
+void BridgeProtocol::encodeRequest(quint32 id, char *out)
+{
+    out[0] = char((id >> 24) & 0xFF);
+    out[1] = char((id >> 16) & 0xFF);
+    out[2] = char((id >> 8) & 0xFF);
+    out[3] = char(id & 0xFF);
+}
+
+int BridgeProtocol::encodeFrame(const CanMessage &msg, char *out)
+{
+    const int dlc = qMin<int>(msg.dlc, 8);
+    out[0] = char(kTxSync);
+    out[1] = char((msg.id >> 24) & 0xFF);
+    out[2] = char((msg.id >> 16) & 0xFF);
+    out[3] = char((msg.id >> 8) & 0xFF);
+    out[4] = char(msg.id & 0xFF);
+    out[5] = char(dlc);
+    memcpy(out + 6, msg.data, size_t(dlc));
+    return 6 + dlc;
+}
+
+// -------------------- LINE PARSER --------------------
+bool BridgeProtocol::parseLine(const char *begin, const char *end, CanMessage *msg, quint64 *deviceUs)
+{
+    const char *p = begin;
+    skipSpaces(p, end);
+    while (end > p && isSpace(end[-1]))
+        end--;
+
+    static const char kPrefix[] = "[ID 0x";
+    const int prefixLength = int(sizeof(kPrefix)) - 1;
+    if (end - p < prefixLength || memcmp(p, kPrefix, prefixLength) != 0)
+        return false;
+    p += prefixLength;
+
+    // ID
+    quint32 id = 0;
+    int digits = 0;
+    for (int v; p < end && (v = hexValue(*p)) >= 0; p++, digits++) {
+        if (digits == 8)
+            return false;
+        id = (id << 4) | quint32(v);
+    }
+    if (digits == 0 || id > kMaxId || p == end || *p != ']')
+        return false;
+    p++;
+
+    // Payload bytes, then the optional timestamp
+    quint8 data[8] = {};
+    int dlc = 0;
+    quint64 stamp = 0;
+    for (;;) {
+        skipSpaces(p, end);
+        if (p == end)
+            break;
+
+        if (*p == 't') {
+            if (end - p < 3 || p[1] != '=')
+                return false;
+            p += 2;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                const quint64 digit = quint64(*p - '0');
+                if (stamp > (~quint64(0) - digit) / 10)
+                    return false;   // Overflow
+                stamp = stamp * 10 + digit;
+            }
+            if (p != end)
+                return false;       // Must be the last token, digits only
+            break;
+        }
+
+        if (end - p < 2)
+            return false;
+        const int high = hexValue(p[0]);
+        const int low = hexValue(p[1]);
+        if (high < 0 || low < 0 || dlc == 8)
+            return false;
+        data[dlc++] = quint8((high << 4) | low);
+        p += 2;
+    }
+
+    msg->id = id;
+    msg->extended = id > CanMessage::kMaxStandardId;
+    msg->rtr = false;
+    msg->dlc = quint8(dlc);
+    memcpy(msg->data, data, 8);
+    msg->tx = false;
+    *deviceUs = stamp;
+    return true;
+}
+
+// -------------------- STREAM DECODER --------------------
+BridgeLineDecoder::BridgeLineDecoder()
+    : readPos(0)
+    , discarding(false)
+{
+}
+
+void BridgeLineDecoder::append(const char *data, int size)
+{
+    // Reclaim consumed space before growing
+    if (readPos > 0 && readPos >= int(buffer.size()) / 2) {
+        buffer.remove(0, readPos);
+        readPos = 0;
+    }
+    buffer.append(data, size);
+}
+
+bool BridgeLineDecoder::next(CanMessage *msg, quint64 *deviceUs, Status *status)
+{
+    const char *data = buffer.constData();
+    const int size = int(buffer.size());
+
+    for (;;) {
+        int lineEnd = readPos;
+        while (lineEnd < size && !isTerminator(data[lineEnd]))
+            lineEnd++;
+
+        if (lineEnd == size) {
+            // Incomplete line: wait for more bytes unless it is already too long
+            if (!discarding && size - readPos > BridgeProtocol::kMaxLineLength) {
+                discarding = true;
+                readPos = size;
+                *status = Status::Error;
+                return true;
+            }
+            if (discarding)
+                readPos = size;
+            return false;
+        }
+
+        const int lineStart = readPos;
+        readPos = lineEnd + 1;
+
+        if (discarding) {
+            // Tail of the overlong line, already reported
+            discarding = false;
+            continue;
+        }
+
+        // Blank lines, including the empty one between "\r" and "\n"
+        bool blank = true;
+        for (int i = lineStart; i < lineEnd && blank; i++)
+            blank = isSpace(data[i]);
+        if (blank)
+            continue;
+
+        if (lineEnd - lineStart > BridgeProtocol::kMaxLineLength
+            || !BridgeProtocol::parseLine(data + lineStart, data + lineEnd, msg, deviceUs)) {
+            *status = Status::Error;
+            return true;
+        }
+
+        *status = Status::Frame;
+        return true;
+    }
+}
+
+void BridgeLineDecoder::reset()
+{
+    buffer.clear();
+    readPos = 0;
+    discarding = false;
+}
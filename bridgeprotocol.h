@@ -0,0 +1,90 @@
+#ifndef BRIDGEPROTOCOL_H
+#define BRIDGEPROTOCOL_H
+
+#include "canmessage.h"
+
+#include <QByteArray>
+
+// STM32 UART bridge protocol, kept free of any I/O so it can be built and
+// exercised on its own (canbridgeprotocol library).
+//
+// Host -> bridge, two encodings:
+//
+// - Request, understood by every bridge firmware: the bare ID, 4 bytes big
+//   endian. The bridge sends it with a zero payload.
+//
+// - Framed record, for emulated traffic. Only firmware that knows the 0xA5
+//   sync byte accepts it; there is no version handshake, so the host only
+//   sends it when the user selected it (SerialTransport::TxProtocol):
+//
+//     u8  sync   0xA5
+//     u32 id     big endian
+//     u8  dlc    0-8
+//     u8  data[dlc]
+//
+//   A request never starts with 0xA5 (IDs are at most 0x1FFFFFFF), so such
+//   firmware can take both encodings on one stream.
+//
+// Bridge -> host: one ASCII line per frame:
+//
+//   [ID 0x1900140] 11 22 33 44 55 66 77 88 t=123456
+//
+// - The ID is 1-8 hex digits, at most 0x1FFFFFFF. The line has no frame
+//   format, so IDs above 0x7FF are taken as extended frames.
+// - The payload is 0-8 bytes of two hex digits each, separated by optional
+//   whitespace. DLC is the number of bytes.
+// - "t=<decimal>" is the bridge's receive time in microseconds, optional and
+//   always last.
+// - Lines end with "\n", "\r\n" or a bare "\r". Blank lines are ignored.
+//
+// Anything else makes the whole line an error; nothing is guessed.
+namespace BridgeProtocol {
+
+const int kMaxLineLength = 512;      // Longer means a lost newline
+const quint32 kMaxId = 0x1FFFFFFF;
+
+const int kRequestSize = 4;
+const quint8 kTxSync = 0xA5;
+const int kMaxTxRecordSize = 1 + 4 + 1 + 8;
+
+// Encodes a request into out (kRequestSize bytes available)
+void encodeRequest(quint32 id, char *out);
+
+// Encodes one framed record into out (kMaxTxRecordSize bytes available),
+// returns its length.
+int encodeFrame(const CanMessage &msg, char *out);
+
+// Decodes one line without its terminator. Leading and trailing whitespace
+// is allowed. msg.timestampNs is not touched; deviceUs is 0 without "t=".
+bool parseLine(const char *begin, const char *end, CanMessage *msg, quint64 *deviceUs);
+
+} // namespace BridgeProtocol
+
+// Splits a byte stream into lines and decodes them. Bytes may arrive in any
+// fragmentation; a partial line is kept until its terminator shows up. A
+// line exceeding kMaxLineLength is reported once as an error and skipped up
+// to the next terminator.
+class BridgeLineDecoder
+{
+public:
+    enum class Status { Frame, Error };
+
+    BridgeLineDecoder();
+
+    void append(const char *data, int size);
+    void append(const QByteArray &data) { append(data.constData(), int(data.size())); }
+
+    // Decodes the next complete line, in stream order. Returns false when
+    // no complete line is buffered.
+    bool next(CanMessage *msg, quint64 *deviceUs, Status *status);
+
+    void reset();       // Drop any partial line
+    int pendingBytes() const { return int(buffer.size()) - readPos; }
+
+private:
+    QByteArray buffer;
+    int readPos;
+    bool discarding;    // Skipping the rest of an overlong line
+};
+
+#endif // BRIDGEPROTOCOL_H
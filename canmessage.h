@@ -0,0 +1,27 @@
+#ifndef CANMESSAGE_H
+#define CANMESSAGE_H
+
+#include <QMetaType>
+#include <QtGlobal>
+
+// Binary representation of a single CAN frame as it travels through the
+// ingest path. Kept trivially copyable so it can be queued and stored
+// without allocations.
+struct CanMessage {
+    quint64 timestampNs = 0; // CaptureClock nanoseconds (epoch based in trace files)
+    quint32 id = 0;
+    quint8 dlc = 0;
+    quint8 data[8] = {};
+    bool tx = false;
+    bool extended = false;   // 29-bit identifier (CAN_EFF_FLAG)
+    bool rtr = false;        // Remote transmission request, data is unused
+
+    // Sources that carry no frame format (bridge lines, scripts, requests)
+    // send IDs above this as extended frames
+    static const quint32 kMaxStandardId = 0x7FF;
+    static const quint32 kMaxExtendedId = 0x1FFFFFFF;
+};
+
+Q_DECLARE_METATYPE(CanMessage)
+
+#endif // CANMESSAGE_H
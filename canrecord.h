@@ -0,0 +1,51 @@
+#ifndef CANRECORD_H
+#define CANRECORD_H
+
+#include "canmessage.h"
+#include "captureclock.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+// Fixed 24-byte little endian on-wire / on-disk frame record, shared by the
+// frame server and session files:
+//   u64 timestamp (ns since the Unix epoch)
+//   u32 id        (bit 31 set for transmitted frames)
+//   u8  dlc, u8 flags (bit 0 extended, bit 1 RTR), u8 reserved[2]
+//   u8  data[8]
+namespace CanRecord {
+
+const int kSize = 24;
+const quint32 kTxFlag = 0x80000000u;
+const quint8 kExtendedFlag = 0x01;
+const quint8 kRtrFlag = 0x02;
+
+inline void write(uchar *out, const CanMessage &msg)
+{
+    qToLittleEndian<quint64>(CaptureClock::toEpochNs(msg.timestampNs), out);
+    qToLittleEndian<quint32>(msg.id | (msg.tx ? kTxFlag : 0u), out + 8);
+    out[12] = msg.dlc;
+    out[13] = quint8((msg.extended ? kExtendedFlag : 0) | (msg.rtr ? kRtrFlag : 0));
+    out[14] = out[15] = 0;
+    memcpy(out + 16, msg.data, 8);
+}
+
+inline CanMessage read(const uchar *in)
+{
+    CanMessage msg;
+    msg.timestampNs = CaptureClock::fromEpochNs(qFromLittleEndian<quint64>(in));
+    const quint32 id = qFromLittleEndian<quint32>(in + 8);
+    msg.id = id & ~kTxFlag;
+    msg.tx = (id & kTxFlag) != 0;
+    msg.dlc = qMin<quint8>(in[12], 8);
+    // Records written before the flags existed have 0 there
+    msg.extended = (in[13] & kExtendedFlag) || msg.id > CanMessage::kMaxStandardId;
+    msg.rtr = (in[13] & kRtrFlag) != 0;
+    memcpy(msg.data, in + 16, 8);
+    return msg;
+}
+
+} // namespace CanRecord
+
+#endif // CANRECORD_H
@@ -0,0 +1,39 @@
+#ifndef CANTRANSPORT_H
+#define CANTRANSPORT_H
+
+#include "canmessage.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+// Frame-level I/O interface shared by the serial bridge and SocketCAN.
+// Received frames are delivered in batches, already timestamped.
+class CanTransport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CanTransport(QObject *parent = nullptr) : QObject(parent) {}
+
+    virtual bool isOpen() const = 0;
+    virtual QString name() const = 0;
+    virtual QString errorString() const = 0;
+
+    // Arbitrary frames (emulated traffic). A transport may only support
+    // requests, writeFrames() then fails.
+    virtual bool canTransmitFrames() const { return true; }
+    virtual bool writeFrames(const CanMessage *frames, int count) = 0;
+    bool writeFrame(const CanMessage &frame) { return writeFrames(&frame, 1); }
+
+    // Request frames from the transmit panel, sent like any other frame
+    // unless a transport needs its own request encoding.
+    virtual bool sendRequest(const CanMessage &request) { return writeFrame(request); }
+
+signals:
+    void framesReceived(const QVector<CanMessage> &frames);
+    void parseError(quint64 timestampNs);    // Undecodable input, frames may be lost
+    void statusChanged();   // Opened, closed or transmit capabilities changed
+};
+
+#endif // CANTRANSPORT_H
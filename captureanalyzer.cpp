@@ -0,0 +1,254 @@
+#include "captureanalyzer.h"
+#include "framefilter.h"
+#include "traceio.h"
+#include "workstealingpool.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+const int kBatchFrames = 4096;
+const int kMaxAnomalies = 10000;
+
+struct ChunkResult {
+    QHash<quint32, IdStatistics> ids;
+    QVector<CaptureAnomaly> anomalies;
+    quint64 frames = 0;
+    qint64 skippedLines = 0;
+    bool ok = true;
+    bool cancelled = false;
+};
+
+void addAnomaly(QVector<CaptureAnomaly> &anomalies, quint64 timestampNs, quint32 id,
+                CaptureAnomaly::Kind kind, quint64 value)
+{
+    if (anomalies.size() >= kMaxAnomalies)
+        return;
+    CaptureAnomaly anomaly;
+    anomaly.timestampNs = timestampNs;
+    anomaly.id = id;
+    anomaly.kind = kind;
+    anomaly.value = value;
+    anomalies.append(anomaly);
+}
+
+void addFindings(QVector<CaptureAnomaly> &anomalies, int findings, quint64 timestampNs, quint32 id,
+                 quint8 dlc, quint64 interval)
+{
+    if (findings & IdStatistics::Late)
+        addAnomaly(anomalies, timestampNs, id, CaptureAnomaly::LateFrame, interval);
+    if (findings & IdStatistics::DlcChanged)
+        addAnomaly(anomalies, timestampNs, id, CaptureAnomaly::DlcChange, dlc);
+}
+
+// -------------------- CHUNK WORKER --------------------
+void processChunk(const QString &path, TraceFormat format, const TraceHeader &header,
+                  qint64 start, qint64 end, const CaptureAnalyzer::Options &options, ChunkResult &out)
+{
+    const int lateFactor = options.lateFactor;
+
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        out.ok = false;
+        return;
+    }
+
+    // Skip the line straddling the range start, the previous chunk owns it
+    if (start > 0) {
+        file.seek(start - 1);
+        file.readLine();
+    }
+
+    TraceReader reader(&file, format);
+    reader.setHeader(header);
+    reader.setEndOffset(end);
+
+    QVector<CanMessage> batch;
+    batch.reserve(kBatchFrames);
+    while (reader.readChunk(batch, kBatchFrames)) {
+        if (options.cancel && *options.cancel) {
+            out.cancelled = true;
+            return;
+        }
+        for (const CanMessage &msg : std::as_const(batch)) {
+            IdStatistics &stats = out.ids[msg.id];
+            stats.id = msg.id;
+            quint64 interval = 0;
+            const int findings = stats.add(msg.timestampNs, msg.dlc, lateFactor, &interval);
+            if (findings)
+                addFindings(out.anomalies, findings, msg.timestampNs, msg.id, msg.dlc, interval);
+        }
+        out.frames += quint64(batch.size());
+    }
+    out.skippedLines = reader.skippedLines();
+}
+
+} // namespace
+
+// -------------------- PER-ID STATISTICS --------------------
+int IdStatistics::add(quint64 timestampNs, quint8 dlc, int lateFactor, quint64 *interval)
+{
+    int findings = None;
+    const quint64 gap = count && timestampNs > lastNs ? timestampNs - lastNs : 0;
+
+    if (count == 0) {
+        firstNs = timestampNs;
+        firstDlc = dlc;
+    } else {
+        if (gap > 0) {
+            if (periods >= kMinPeriodsForLate && gap * periods > quint64(lateFactor) * periodSumNs)
+                findings |= Late;
+            if (periods == 0 || gap < minPeriodNs)
+                minPeriodNs = gap;
+            if (gap > maxPeriodNs)
+                maxPeriodNs = gap;
+            periodSumNs += gap;
+            periods++;
+        }
+        if (dlc != lastDlc) {
+            dlcChanges++;
+            findings |= DlcChanged;
+        }
+    }
+
+    lastNs = timestampNs;
+    lastDlc = dlc;
+    count++;
+    if (interval)
+        *interval = gap;
+    return findings;
+}
+
+int IdStatistics::merge(const IdStatistics &next, int lateFactor, quint64 *interval)
+{
+    if (next.count == 0)
+        return None;
+
+    // The interval across the boundary and next's first frame
+    const int findings = add(next.firstNs, next.firstDlc, lateFactor, interval);
+
+    if (next.periods) {
+        minPeriodNs = periods ? std::min(minPeriodNs, next.minPeriodNs) : next.minPeriodNs;
+        maxPeriodNs = std::max(maxPeriodNs, next.maxPeriodNs);
+    }
+    periodSumNs += next.periodSumNs;
+    periods += next.periods;
+    dlcChanges += next.dlcChanges;
+    count += next.count - 1;
+    lastNs = next.lastNs;
+    lastDlc = next.lastDlc;
+    return findings;
+}
+
+// -------------------- ANALYZE --------------------
+bool CaptureAnalyzer::analyze(const QString &path, const Options &options,
+                              CaptureAnalysis *result, QString *error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const TraceFormat format = traceFormatForPath(path);
+    if (format == TraceFormat::Unknown) {
+        if (error)
+            *error = "Unsupported trace format (use .log, .asc or .csv)";
+        return false;
+    }
+
+    const qint64 size = QFileInfo(path).size();
+
+    // ASC ID base and measurement start come from the header, which only
+    // the first range contains: read it once and hand it to every range
+    TraceHeader header;
+    {
+        QFile file(path);
+        if (!file.open(QFile::ReadOnly)) {
+            if (error)
+                *error = file.errorString();
+            return false;
+        }
+        header = TraceReader::readHeader(&file, format);
+    }
+
+    // Relative timestamps accumulate from the first event: one range only
+    const qint64 chunkBytes = header.relativeTimestamps ? std::max<qint64>(size, 1)
+                                                        : std::max<qint64>(options.chunkBytes, 1 << 16);
+    const int chunkCount = int(std::max<qint64>(1, (size + chunkBytes - 1) / chunkBytes));
+
+    std::vector<ChunkResult> chunks(size_t(chunkCount));
+    WorkStealingPool pool(options.threads);
+    for (int i = 0; i < chunkCount; i++) {
+        const qint64 start = qint64(i) * chunkBytes;
+        const qint64 end = std::min(size, start + chunkBytes);
+        ChunkResult *out = &chunks[size_t(i)];
+        pool.submit([&path, format, &header, start, end, &options, out]() {
+            processChunk(path, format, header, start, end, options, *out);
+        });
+    }
+    pool.run();
+
+    // Deterministic merge in file order
+    CaptureAnalysis analysis;
+    QHash<quint32, IdStatistics> merged;
+    for (const ChunkResult &chunk : chunks) {
+        if (!chunk.ok || chunk.cancelled) {
+            if (error)
+                *error = chunk.ok ? QString("Cancelled") : "Cannot read " + path;
+            return false;
+        }
+
+        analysis.frames += chunk.frames;
+        analysis.skippedLines += chunk.skippedLines;
+        analysis.anomalies += chunk.anomalies;
+
+        for (auto it = chunk.ids.constBegin(); it != chunk.ids.constEnd(); ++it) {
+            auto existing = merged.find(it.key());
+            if (existing == merged.end()) {
+                merged.insert(it.key(), it.value());
+            } else {
+                // Collected separately so the chunk cap never drops these
+                QVector<CaptureAnomaly> boundary;
+                const IdStatistics &next = it.value();
+                quint64 interval = 0;
+                const int findings = existing.value().merge(next, options.lateFactor, &interval);
+                addFindings(boundary, findings, next.firstNs, next.id, next.firstDlc, interval);
+                analysis.anomalies += boundary;
+            }
+        }
+    }
+
+    const FrameFilter filter(options.idFilter);
+    analysis.ids.reserve(merged.size());
+    for (auto it = merged.begin(); it != merged.end(); ++it) {
+        IdStatistics &stats = it.value();
+        // Evaluated once per distinct ID instead of once per frame
+        stats.matchesFilter = filter.matches(stats.id);
+        if (stats.matchesFilter)
+            analysis.filterMatches += stats.count;
+        analysis.ids.append(stats);
+    }
+    std::sort(analysis.ids.begin(), analysis.ids.end(),
+              [](const IdStatistics &a, const IdStatistics &b) { return a.id < b.id; });
+
+    std::sort(analysis.anomalies.begin(), analysis.anomalies.end(),
+              [](const CaptureAnomaly &a, const CaptureAnomaly &b) {
+                  if (a.timestampNs != b.timestampNs) return a.timestampNs < b.timestampNs;
+                  if (a.id != b.id) return a.id < b.id;
+                  if (a.kind != b.kind) return a.kind < b.kind;
+                  return a.value < b.value;
+              });
+    if (analysis.anomalies.size() > kMaxAnomalies)
+        analysis.anomalies.resize(kMaxAnomalies);
+
+    analysis.bytes = size;
+    analysis.chunks = chunkCount;
+    analysis.threads = pool.threadCount();
+    analysis.elapsedMs = timer.elapsed();
+    *result = analysis;
+    return true;
+}
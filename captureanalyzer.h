@@ -0,0 +1,89 @@
+#ifndef CAPTUREANALYZER_H
+#define CAPTUREANALYZER_H
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+// Per-ID statistics over a capture. add() is the one accumulator behind
+// the offline analyzer, the session statistics and the live anomaly
+// detector, so all three agree on the same frames.
+struct IdStatistics {
+    enum Finding { None = 0, Late = 1, DlcChanged = 2 };
+
+    static const quint64 kMinPeriodsForLate = 8;   // Learn the period before judging gaps
+    static const int kDefaultLateFactor = 3;
+
+    quint32 id = 0;
+    quint64 count = 0;
+    quint64 firstNs = 0;
+    quint64 lastNs = 0;
+    quint64 minPeriodNs = 0;
+    quint64 maxPeriodNs = 0;
+    quint64 periodSumNs = 0;
+    quint64 periods = 0;
+    quint8 firstDlc = 0;
+    quint8 lastDlc = 0;
+    quint64 dlcChanges = 0;
+    bool matchesFilter = false;
+
+    // Accounts one frame and returns its Finding flags, judged against the
+    // statistics before it. An interval of zero or less (frames stamped by
+    // the same read) says nothing about the period and is left out. A gap
+    // above lateFactor x the mean period is late. interval receives the gap.
+    int add(quint64 timestampNs, quint8 dlc, int lateFactor = kDefaultLateFactor,
+            quint64 *interval = nullptr);
+
+    // Appends a later stretch of the same ID; returns the findings for the
+    // interval across the boundary.
+    int merge(const IdStatistics &next, int lateFactor = kDefaultLateFactor, quint64 *interval = nullptr);
+
+    quint64 meanPeriodNs() const { return periods ? periodSumNs / periods : 0; }
+    double meanPeriodMs() const { return periods ? double(periodSumNs) / double(periods) / 1e6 : 0.0; }
+};
+
+struct CaptureAnomaly {
+    enum Kind { DlcChange, LateFrame };
+
+    quint64 timestampNs = 0;
+    quint32 id = 0;
+    Kind kind = DlcChange;
+    quint64 value = 0;       // New DLC, or the gap in ns for late frames
+};
+
+struct CaptureAnalysis {
+    quint64 frames = 0;
+    qint64 skippedLines = 0;
+    quint64 filterMatches = 0;
+    QVector<IdStatistics> ids;            // Sorted by ID
+    QVector<CaptureAnomaly> anomalies;    // Sorted by time, capped
+    qint64 bytes = 0;
+    int chunks = 0;
+    int threads = 0;
+    qint64 elapsedMs = 0;
+};
+
+// Offline analysis of large recorded traces (candump, ASC, CSV).
+//
+// The file is split into fixed byte ranges aligned to line starts. Each range
+// is decoded and analysed independently on a work-stealing pool, then the
+// partial results are merged in file order, stitching per-ID periods across
+// chunk boundaries. Chunking does not depend on the thread count, so the
+// result is identical however many cores are used.
+class CaptureAnalyzer
+{
+public:
+    struct Options {
+        QString idFilter;                // Same substring match as the monitor filter
+        int threads = 0;                 // 0 = all cores
+        qint64 chunkBytes = 32 << 20;
+        int lateFactor = IdStatistics::kDefaultLateFactor;  // Gap > factor x mean period is an anomaly
+        const std::atomic<bool> *cancel = nullptr;  // Checked between batches
+    };
+
+    static bool analyze(const QString &path, const Options &options,
+                        CaptureAnalysis *result, QString *error = nullptr);
+};
+
+#endif // CAPTUREANALYZER_H
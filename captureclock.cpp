@@ -0,0 +1,64 @@
+#include "captureclock.h"
+
+#include <chrono>
+
+// Weight of a new sample when the offset creeps up (1 / 2^kDriftShift)
+static const int kDriftShift = 10;
+
+// -------------------- CAPTURE CLOCK --------------------
+quint64 CaptureClock::nowNs()
+{
+    return quint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+qint64 CaptureClock::epochOffsetNs()
+{
+    static const qint64 offset = [] {
+        qint64 wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return wall - qint64(nowNs());
+    }();
+    return offset;
+}
+
+quint64 CaptureClock::toEpochNs(quint64 monotonicNs)
+{
+    return quint64(qint64(monotonicNs) + epochOffsetNs());
+}
+
+quint64 CaptureClock::fromEpochNs(quint64 epochNs)
+{
+    return quint64(qint64(epochNs) - epochOffsetNs());
+}
+
+// -------------------- DEVICE CLOCK SYNC --------------------
+DeviceClockSync::DeviceClockSync()
+{
+    reset();
+}
+
+void DeviceClockSync::reset()
+{
+    offsetNs = 0;
+    lastDeviceNs = 0;
+    synced = false;
+}
+
+quint64 DeviceClockSync::map(quint64 deviceNs, quint64 hostNs)
+{
+    // Device reset or counter wrap: start over
+    if (synced && deviceNs < lastDeviceNs)
+        synced = false;
+    lastDeviceNs = deviceNs;
+
+    const qint64 sample = qint64(hostNs) - qint64(deviceNs);
+    if (!synced || sample < offsetNs) {
+        offsetNs = sample;
+        synced = true;
+    } else {
+        offsetNs += (sample - offsetNs) >> kDriftShift;
+    }
+
+    return quint64(qint64(deviceNs) + offsetNs);
+}
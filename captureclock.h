@@ -0,0 +1,38 @@
+#ifndef CAPTURECLOCK_H
+#define CAPTURECLOCK_H
+
+#include <QtGlobal>
+
+// Monotonic nanosecond clock used to stamp frames at byte arrival.
+// Never jumps with wall-clock changes; converted to wall-clock time only
+// for display and export, through an offset sampled once at startup.
+class CaptureClock
+{
+public:
+    static quint64 nowNs();
+    static quint64 toEpochNs(quint64 monotonicNs);
+    static quint64 fromEpochNs(quint64 epochNs);
+
+private:
+    static qint64 epochOffsetNs();
+};
+
+// Maps a device-side clock (bridge firmware counter, NIC hardware clock)
+// onto the capture clock. Tracks the minimum observed host-device offset,
+// which is the sample with the least transport latency, and lets it creep
+// slowly to follow oscillator drift. O(1) per frame.
+class DeviceClockSync
+{
+public:
+    DeviceClockSync();
+
+    quint64 map(quint64 deviceNs, quint64 hostNs);
+    void reset();
+
+private:
+    qint64 offsetNs;
+    quint64 lastDeviceNs;
+    bool synced;
+};
+
+#endif // CAPTURECLOCK_H
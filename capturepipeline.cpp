@@ -0,0 +1,199 @@
+#include "capturepipeline.h"
+#include "cantransport.h"
+#include "captureclock.h"
+#include "emulationengine.h"
+#include "frameserver.h"
+#include "sessionstore.h"
+#include "triggercapture.h"
+
+#include <QTimer>
+
+CapturePipeline::CapturePipeline(QObject *parent)
+    : QObject(parent)
+    , activeTransport(nullptr)
+    , session(nullptr)
+    , frameServer(nullptr)
+    , emulator(new EmulationEngine(this))
+    , triggerCapture(new TriggerCapture(this))
+    , missingTimer(new QTimer(this))
+    , startNs(CaptureClock::nowNs())
+    , recordingPaused(false)
+{
+    connect(emulator, &EmulationEngine::transmit, this, &CapturePipeline::onEmulatedFrames);
+
+    // Cyclic IDs that stop arriving are only noticed by polling
+    connect(missingTimer, &QTimer::timeout, this, &CapturePipeline::checkMissing);
+    missingTimer->start(100);
+}
+
+// -------------------- SINKS / TRANSPORT --------------------
+void CapturePipeline::setSessionStore(SessionStore *store)
+{
+    session = store;
+    if (session)
+        replaceFrames(session->restored().recentFrames);
+}
+
+void CapturePipeline::setTransport(CanTransport *transport)
+{
+    if (transport == activeTransport)
+        return;
+    if (activeTransport)
+        disconnect(activeTransport, nullptr, this, nullptr);
+
+    activeTransport = transport;
+
+    if (activeTransport) {
+        connect(activeTransport, &CanTransport::framesReceived, this, &CapturePipeline::onFramesReceived);
+        connect(activeTransport, &CanTransport::parseError, this, &CapturePipeline::onParseError);
+        connect(activeTransport, &CanTransport::statusChanged, this, &CapturePipeline::transportChanged);
+    }
+    emit transportChanged();
+}
+
+bool CapturePipeline::isConnected() const
+{
+    return activeTransport && activeTransport->isOpen();
+}
+
+bool CapturePipeline::canTransmitFrames() const
+{
+    return isConnected() && activeTransport->canTransmitFrames();
+}
+
+// -------------------- INGEST --------------------
+void CapturePipeline::onFramesReceived(const QVector<CanMessage> &frames)
+{
+    triggerCapture->onFrames(frames);
+
+    const quint64 eventsBefore = anomalies.totalEvents();
+    for (const CanMessage &msg : frames) {
+        anomalies.onFrame(msg);
+        store(msg);
+    }
+
+    if (session && !recordingPaused)
+        session->append(frames);
+    if (frameServer)
+        frameServer->publish(frames);
+
+    // Immediate replies are recorded after the frames that caused them
+    emulator->onFramesReceived(frames);
+
+    emit framesChanged();
+    if (anomalies.totalEvents() != eventsBefore)
+        emit eventsChanged();
+}
+
+void CapturePipeline::onParseError(quint64 timestampNs)
+{
+    anomalies.onParseError(timestampNs);
+    emit eventsChanged();
+}
+
+void CapturePipeline::checkMissing()
+{
+    const quint64 before = anomalies.totalEvents();
+    anomalies.checkMissing(CaptureClock::nowNs());
+    if (anomalies.totalEvents() != before)
+        emit eventsChanged();
+}
+
+// -------------------- TRANSMIT --------------------
+bool CapturePipeline::transmit(const QVector<CanMessage> &frames)
+{
+    if (frames.isEmpty())
+        return true;
+    if (!activeTransport || !activeTransport->writeFrames(frames.constData(), frames.size()))
+        return false;
+    recordTransmitted(frames.constData(), frames.size());
+    return true;
+}
+
+bool CapturePipeline::sendRequest(const CanMessage &request)
+{
+    if (!activeTransport || !activeTransport->sendRequest(request))
+        return false;
+    recordTransmitted(&request, 1);
+    return true;
+}
+
+void CapturePipeline::onEmulatedFrames(const QVector<CanMessage> &frames)
+{
+    // One write, one session append and one publish per emulation batch;
+    // views coalesce repaints
+    transmit(frames);
+}
+
+void CapturePipeline::recordTransmitted(const CanMessage *frames, int count)
+{
+    // Reused, so steady emulated traffic does not allocate per batch
+    const quint64 now = CaptureClock::nowNs();
+    sentBatch.resize(0);
+    for (int i = 0; i < count; i++) {
+        CanMessage sent = frames[i];
+        sent.timestampNs = now;
+        sent.tx = true;
+        store(sent);
+        sentBatch.append(sent);
+    }
+
+    if (session && !recordingPaused)
+        session->append(sentBatch);
+    if (frameServer)
+        frameServer->publish(sentBatch);
+
+    emit framesChanged();
+}
+
+// -------------------- FRAME STORE --------------------
+void CapturePipeline::store(const CanMessage &msg)
+{
+    // Bytes that differ from the previous frame with the same ID
+    quint8 changed = 0;
+    auto previous = lastFrameById.find(msg.id);
+    if (previous != lastFrameById.end()) {
+        for (int i = 0; i < msg.dlc; i++) {
+            if (i >= previous->dlc || msg.data[i] != previous->data[i])
+                changed |= quint8(1u << i);
+        }
+        *previous = msg;
+    } else {
+        lastFrameById.insert(msg.id, msg);
+    }
+
+    recentFrames.prepend(msg);
+    changedBytes.prepend(changed);
+    if (recentFrames.size() > kMaxFrames) {
+        recentFrames.resize(kMaxFrames);
+        changedBytes.resize(kMaxFrames);
+    }
+}
+
+void CapturePipeline::clear()
+{
+    recentFrames.clear();
+    changedBytes.clear();
+    lastFrameById.clear();
+    anomalies.clear();
+    startNs = CaptureClock::nowNs();
+
+    emit framesChanged();
+    emit eventsChanged();
+}
+
+void CapturePipeline::replaceFrames(const QVector<CanMessage> &frames)
+{
+    recentFrames.clear();
+    changedBytes.clear();
+    lastFrameById.clear();
+    anomalies.clear();
+
+    // The store is newest first, frames are chronological
+    for (const CanMessage &msg : frames)
+        store(msg);
+    startNs = frames.isEmpty() ? CaptureClock::nowNs() : frames.first().timestampNs;
+
+    emit framesChanged();
+    emit eventsChanged();
+}
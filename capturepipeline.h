@@ -0,0 +1,97 @@
+#ifndef CAPTUREPIPELINE_H
+#define CAPTUREPIPELINE_H
+
+#include "anomalydetector.h"
+#include "canmessage.h"
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+class CanTransport;
+class EmulationEngine;
+class FrameServer;
+class QTimer;
+class SessionStore;
+class TriggerCapture;
+
+// Ingest pipeline and frame store, free of any view.
+//
+// Received frames go through here once and are fanned out, in order, to the
+// triggered capture, the anomaly detector, the frame store, the emulated
+// nodes, the session file and the frame server. Transmitted frames (requests
+// and emulated traffic) are stored, recorded in the session and published.
+//
+// Views only observe: they read frames() and detector() when the signals
+// fire and coalesce their repaints themselves. The pipeline keeps running
+// whether or not a view exists.
+class CapturePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int kMaxFrames = 50;   // Frames kept in the store, newest first
+
+    explicit CapturePipeline(QObject *parent = nullptr);
+
+    // Sinks, not owned. The session's restored tail is loaded into the store.
+    void setSessionStore(SessionStore *store);
+    void setFrameServer(FrameServer *server) { frameServer = server; }
+    SessionStore *sessionStore() const { return session; }
+
+    void setTransport(CanTransport *transport);
+    CanTransport *transport() const { return activeTransport; }
+    bool isConnected() const;
+    bool canTransmitFrames() const;     // Emulated traffic can be sent
+
+    // Write to the transport and record the frames as TX on success
+    bool transmit(const QVector<CanMessage> &frames);
+    bool sendRequest(const CanMessage &request);
+
+    // Frame store
+    const QVector<CanMessage> &frames() const { return recentFrames; }
+    quint8 changedMask(int index) const { return changedBytes[index]; }   // Bit i = data[i] changed
+    quint64 captureStartNs() const { return startNs; }
+
+    void clear();       // Empties the store and the detector, the session is kept
+    void replaceFrames(const QVector<CanMessage> &frames);   // Oldest first, e.g. after an import
+
+    // While paused nothing is appended to the session, e.g. during an import
+    void setRecordingPaused(bool paused) { recordingPaused = paused; }
+
+    const AnomalyDetector &detector() const { return anomalies; }
+    EmulationEngine *emulation() const { return emulator; }
+    TriggerCapture *trigger() const { return triggerCapture; }
+
+signals:
+    void framesChanged();       // Store appended to, cleared or replaced
+    void eventsChanged();       // New anomaly events
+    void transportChanged();    // Replaced, opened or closed
+
+private slots:
+    void onFramesReceived(const QVector<CanMessage> &frames);
+    void onParseError(quint64 timestampNs);
+    void onEmulatedFrames(const QVector<CanMessage> &frames);
+    void checkMissing();
+
+private:
+    void store(const CanMessage &msg);
+    void recordTransmitted(const CanMessage *frames, int count);
+
+    CanTransport *activeTransport;
+    SessionStore *session;
+    FrameServer *frameServer;
+    EmulationEngine *emulator;
+    TriggerCapture *triggerCapture;
+    AnomalyDetector anomalies;
+    QTimer *missingTimer;
+
+    QVector<CanMessage> recentFrames;
+    QVector<quint8> changedBytes;             // Per recentFrames entry
+    QVector<CanMessage> sentBatch;            // Stamped TX frames, capacity reused
+    QHash<quint32, CanMessage> lastFrameById; // Reference for changedBytes
+    quint64 startNs;                          // Reference for relative timestamps
+    bool recordingPaused;
+};
+
+#endif // CAPTUREPIPELINE_H
@@ -0,0 +1,290 @@
+#include "emulationengine.h"
+
+#include <QFile>
+#include <QTimer>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace {
+
+const qint64 kNsPerMs = 1000000;
+
+bool parseId(const QString &token, quint32 *id)
+{
+    bool ok = false;
+    *id = token.toUInt(&ok, 0);
+    return ok && *id <= 0x1FFFFFFF;
+}
+
+} // namespace
+
+// -------------------- CONSTRUCTOR --------------------
+EmulationEngine::EmulationEngine(QObject *parent)
+    : QObject(parent)
+    , nodes(0)
+    , timer(new QTimer(this))
+    , running(false)
+{
+    timer->setTimerType(Qt::PreciseTimer);
+    timer->setSingleShot(true);
+    connect(timer, &QTimer::timeout, this, &EmulationEngine::tick);
+    clock.start();
+}
+
+// -------------------- SCRIPT LOADING --------------------
+bool EmulationEngine::loadScriptFile(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    return loadScript(QString::fromUtf8(file.readAll()), error);
+}
+
+bool EmulationEngine::loadScript(const QString &source, QString *error)
+{
+    QVector<Rule> newRules;
+    QHash<quint32, QVector<int>> newReplyTable;
+    QVector<int> newPeriodic;
+    int newNodes = 0;
+
+    const QStringList lines = source.split('\n');
+    for (int lineNo = 0; lineNo < lines.size(); lineNo++) {
+        QString line = lines[lineNo];
+        int comment = line.indexOf('#');
+        if (comment != -1)
+            line.truncate(comment);
+
+        const QStringList tokens = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        if (tokens.isEmpty())
+            continue;
+
+        auto fail = [&](const QString &message) {
+            if (error)
+                *error = QString("Line %1: %2").arg(lineNo + 1).arg(message);
+            return false;
+        };
+
+        const QString keyword = tokens[0].toLower();
+        if (keyword == "node") {
+            newNodes++;
+            continue;
+        }
+
+        Rule rule;
+        quint32 rxId = 0;
+        int i = 0;
+
+        if (keyword == "on") {
+            // on <rx id> reply <tx id> [after <ms>] data ...
+            if (tokens.size() < 4 || tokens[2].toLower() != "reply")
+                return fail("expected 'on <id> reply <id>'");
+            if (!parseId(tokens[1], &rxId) || !parseId(tokens[3], &rule.frame.id))
+                return fail("invalid CAN ID");
+            i = 4;
+        } else if (keyword == "every") {
+            // every <ms> send <tx id> data ...
+            bool ok = false;
+            int period = tokens.size() > 1 ? tokens[1].toInt(&ok) : 0;
+            if (!ok || period <= 0)
+                return fail("invalid period");
+            if (tokens.size() < 4 || tokens[2].toLower() != "send")
+                return fail("expected 'every <ms> send <id>'");
+            if (!parseId(tokens[3], &rule.frame.id))
+                return fail("invalid CAN ID");
+            rule.intervalNs = period * kNsPerMs;
+            rule.periodic = true;
+            i = 4;
+        } else {
+            return fail("unknown statement '" + tokens[0] + "'");
+        }
+
+        while (i < tokens.size()) {
+            const QString option = tokens[i++].toLower();
+            bool ok = true;
+            if (option == "after" && keyword == "on" && i < tokens.size()) {
+                int delay = tokens[i++].toInt(&ok);
+                if (!ok || delay < 0)
+                    return fail("invalid delay");
+                rule.intervalNs = delay * kNsPerMs;
+            } else if (option == "data") {
+                rule.frame.dlc = 0;
+                while (i < tokens.size() && rule.frame.dlc < 8) {
+                    uint value = tokens[i].toUInt(&ok, 16);
+                    if (!ok || value > 0xFF)
+                        break;
+                    rule.frame.data[rule.frame.dlc++] = quint8(value);
+                    i++;
+                }
+                ok = true;
+            } else if ((option == "counter" || option == "checksum") && i < tokens.size()) {
+                int index = tokens[i++].toInt(&ok);
+                if (!ok || index < 0 || index > 7)
+                    return fail("byte index must be 0..7");
+                (option == "counter" ? rule.counterByte : rule.checksumByte) = index;
+            } else {
+                return fail("unexpected '" + option + "'");
+            }
+        }
+
+        if (rule.counterByte >= rule.frame.dlc || rule.checksumByte >= rule.frame.dlc)
+            return fail("counter/checksum byte outside of data");
+        rule.frame.extended = rule.frame.id > CanMessage::kMaxStandardId;
+
+        const int index = newRules.size();
+        newRules.append(rule);
+        if (keyword == "on")
+            newReplyTable[rxId].append(index);
+        else
+            newPeriodic.append(index);
+    }
+
+    rules = newRules;
+    replyTable = newReplyTable;
+    periodicRules = newPeriodic;
+    nodes = newNodes;
+    scriptSource = source;
+    pending.clear();
+
+    if (running) {
+        stop();
+        start();
+    }
+    return true;
+}
+
+// -------------------- START / STOP --------------------
+void EmulationEngine::start()
+{
+    const qint64 now = clock.nsecsElapsed();
+    pending.clear();
+    for (int index : std::as_const(periodicRules))
+        schedule(now + rules[index].intervalNs, index);
+
+    lateness = LatenessStats();
+    running = true;
+    scheduleTimer();
+}
+
+void EmulationEngine::stop()
+{
+    running = false;
+    pending.clear();
+    timer->stop();
+}
+
+// -------------------- INGEST --------------------
+void EmulationEngine::onFramesReceived(const QVector<CanMessage> &frames)
+{
+    if (!running || replyTable.isEmpty())
+        return;
+
+    const qint64 now = clock.nsecsElapsed();
+    bool scheduled = false;
+    for (const CanMessage &msg : frames) {
+        auto it = replyTable.constFind(msg.id);
+        if (it == replyTable.constEnd())
+            continue;
+
+        for (int index : it.value()) {
+            Rule &rule = rules[index];
+            if (rule.intervalNs == 0) {
+                emitRule(rule);
+            } else {
+                schedule(now + rule.intervalNs, index);
+                scheduled = true;
+            }
+        }
+    }
+
+    flush();
+    if (scheduled)
+        scheduleTimer();
+}
+
+// -------------------- SCHEDULER --------------------
+// Delayed replies and periodic rules share one min-heap; the timer is a
+// single shot armed for the earliest due entry, so an idle engine and long
+// periods cost no wakeups.
+void EmulationEngine::schedule(qint64 dueNs, int rule)
+{
+    pending.push_back({dueNs, rule});
+    std::push_heap(pending.begin(), pending.end(), std::greater<Pending>());
+}
+
+void EmulationEngine::tick()
+{
+    const qint64 now = clock.nsecsElapsed();
+
+    if (running && !pending.empty() && pending.front().dueNs <= now) {
+        const qint64 late = now - pending.front().dueNs;
+        lateness.ticks++;
+        lateness.worstNs = qMax(lateness.worstNs, late);
+        if (late > kLatenessBudgetNs)
+            lateness.lateTicks++;
+    }
+
+    while (running && !pending.empty() && pending.front().dueNs <= now) {
+        std::pop_heap(pending.begin(), pending.end(), std::greater<Pending>());
+        const Pending due = pending.back();
+        pending.pop_back();
+
+        Rule &rule = rules[due.rule];
+        emitRule(rule);
+
+        if (rule.periodic) {
+            qint64 next = due.dueNs + rule.intervalNs;
+            if (next <= now) // fell behind, skip missed cycles
+                next = now + rule.intervalNs;
+            schedule(next, due.rule);
+        }
+    }
+
+    flush();
+    scheduleTimer();
+}
+
+void EmulationEngine::scheduleTimer()
+{
+    if (!running || pending.empty()) {
+        timer->stop();
+        return;
+    }
+
+    // Round up so the timer never fires before the entry is due
+    const qint64 waitNs = pending.front().dueNs - clock.nsecsElapsed();
+    timer->start(int(qMax<qint64>(0, (waitNs + kNsPerMs - 1) / kNsPerMs)));
+}
+
+void EmulationEngine::emitRule(Rule &rule)
+{
+    CanMessage &frame = rule.frame;
+
+    if (rule.counterByte >= 0)
+        frame.data[rule.counterByte] = rule.counter++;
+
+    if (rule.checksumByte >= 0) {
+        quint8 sum = 0;
+        for (int i = 0; i < frame.dlc; i++) {
+            if (i != rule.checksumByte)
+                sum += frame.data[i];
+        }
+        frame.data[rule.checksumByte] = sum;
+    }
+
+    outgoing.append(frame);
+}
+
+void EmulationEngine::flush()
+{
+    if (outgoing.isEmpty())
+        return;
+    emit transmit(outgoing);
+    outgoing.resize(0);     // Keeps the capacity for the next batch
+}
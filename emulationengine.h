@@ -0,0 +1,112 @@
+#ifndef EMULATIONENGINE_H
+#define EMULATIONENGINE_H
+
+#include "canmessage.h"
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QString>
+#include <QElapsedTimer>
+
+#include <vector>
+
+class QTimer;
+
+// Rule engine that emulates ECU nodes on the bus.
+//
+// Scripts are plain text, one statement per line ('#' starts a comment):
+//
+//   node BMS
+//   on 0x1900140 reply 0x1900141 after 2 data 64 00 10 27 00 00 00 00
+//   every 10 send 0x123 data 00 00 00 00 00 00 00 00 counter 6 checksum 7
+//
+// "on" rules answer a received ID, optionally after a delay in ms.
+// "every" rules emit a frame periodically (period in ms).
+// "counter N" increments byte N on every emission, "checksum N" stores the
+// 8-bit sum of the remaining payload bytes in byte N.
+//
+// Reply rules are compiled into a per-ID dispatch table so the ingest path
+// only pays one hash lookup per received frame.
+//
+// Frames due together leave as one batch: everything due in a timer tick,
+// and all immediate replies to a received batch, so transmit, session and
+// frame server are called once per batch.
+//
+// The engine runs on the GUI thread like the transports it answers and
+// writes to; a worker thread would still hand every frame back to the GUI
+// thread. Timing is therefore checked rather than assumed: each tick's
+// delay past its earliest due entry is measured, and ticks later than
+// kLatenessBudgetNs are counted (latenessStats()) and shown by the monitor.
+class EmulationEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const qint64 kLatenessBudgetNs = 2000000;
+
+    struct LatenessStats {
+        quint64 ticks = 0;          // Timer ticks that emitted frames
+        quint64 lateTicks = 0;      // Later than kLatenessBudgetNs
+        qint64 worstNs = 0;
+    };
+
+    explicit EmulationEngine(QObject *parent = nullptr);
+
+    bool loadScript(const QString &source, QString *error = nullptr);
+    bool loadScriptFile(const QString &path, QString *error = nullptr);
+
+    void start();
+    void stop();
+    bool isRunning() const { return running; }
+
+    int nodeCount() const { return nodes; }
+    int ruleCount() const { return rules.size(); }
+    QString script() const { return scriptSource; }   // Source of the loaded script
+    const LatenessStats &latenessStats() const { return lateness; }   // Since start()
+
+public slots:
+    void onFramesReceived(const QVector<CanMessage> &frames); // called from the ingest path
+
+signals:
+    void transmit(const QVector<CanMessage> &frames);
+
+private slots:
+    void tick();
+
+private:
+    struct Rule {
+        CanMessage frame;
+        qint64 intervalNs = 0;  // reply delay or period
+        bool periodic = false;
+        int counterByte = -1;
+        int checksumByte = -1;
+        quint8 counter = 0;
+    };
+
+    struct Pending {
+        qint64 dueNs;
+        int rule;
+        bool operator>(const Pending &other) const { return dueNs > other.dueNs; }
+    };
+
+    void emitRule(Rule &rule);
+    void flush();
+    void schedule(qint64 dueNs, int rule);
+    void scheduleTimer();
+
+    QVector<Rule> rules;
+    QHash<quint32, QVector<int>> replyTable; // RX id -> reply rules
+    QVector<int> periodicRules;
+    std::vector<Pending> pending;            // min-heap on dueNs, replies and periodic rules
+    QVector<CanMessage> outgoing;            // Batch being collected, capacity reused
+    LatenessStats lateness;
+    int nodes;
+    QString scriptSource;
+
+    QTimer *timer;
+    QElapsedTimer clock;
+    bool running;
+};
+
+#endif // EMULATIONENGINE_H
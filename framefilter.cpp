@@ -0,0 +1,38 @@
+#include "framefilter.h"
+
+#include <cstring>
+
+FrameFilter::FrameFilter(const QString &text)
+    : pattern(text.toLower().toLatin1())
+{
+}
+
+bool FrameFilter::matches(quint32 id) const
+{
+    if (pattern.isEmpty())
+        return true;
+
+    // "0x" + at least 7 lower case hex digits, as QString::arg(id, 7, 16, '0')
+    static const char kHexDigits[] = "0123456789abcdef";
+    char digits[8];
+    int count = 0;
+    do {
+        digits[count++] = kHexDigits[id & 0xF];
+        id >>= 4;
+    } while (id != 0);
+    while (count < 7)
+        digits[count++] = '0';
+
+    char text[10] = { '0', 'x' };
+    for (int i = 0; i < count; i++)
+        text[2 + i] = digits[count - 1 - i];
+    const int length = 2 + count;
+
+    const int patternLength = int(pattern.size());
+    const char *needle = pattern.constData();
+    for (int start = 0; start + patternLength <= length; start++) {
+        if (memcmp(text + start, needle, size_t(patternLength)) == 0)
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,27 @@
+#ifndef FRAMEFILTER_H
+#define FRAMEFILTER_H
+
+#include <QByteArray>
+#include <QString>
+
+// ID filter shared by the live monitor and offline analysis: a frame passes
+// when the filter text is a case-insensitive substring of its ID written as
+// "0x" plus 7 hex digits (the form shown in the monitor). An empty filter
+// passes everything.
+//
+// matches() formats into a stack buffer and compares bytes, no QString is
+// built per frame.
+class FrameFilter
+{
+public:
+    FrameFilter() = default;
+    explicit FrameFilter(const QString &text);
+
+    bool isEmpty() const { return pattern.isEmpty(); }
+    bool matches(quint32 id) const;
+
+private:
+    QByteArray pattern;     // Lower case Latin-1
+};
+
+#endif // FRAMEFILTER_H
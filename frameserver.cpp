@@ -0,0 +1,200 @@
+#include "frameserver.h"
+#include "canrecord.h"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QDebug>
+
+#include <cstring>
+#include <utility>
+
+static const char kHello[] = "CANEMU01";
+static const int kMaxCommandLength = 256;
+static const int kProbeTimeoutMs = 200;
+
+FrameServer::FrameServer(QObject *parent)
+    : QObject(parent)
+    , tcpServer(new QTcpServer(this))
+    , localServer(new QLocalServer(this))
+{
+    connect(tcpServer, &QTcpServer::newConnection, this, &FrameServer::acceptTcp);
+    connect(localServer, &QLocalServer::newConnection, this, &FrameServer::acceptLocal);
+}
+
+FrameServer::~FrameServer()
+{
+    qDeleteAll(clients);
+}
+
+bool FrameServer::listen(quint16 tcpPort, const QString &localName)
+{
+    bool tcpOk = tcpServer->listen(QHostAddress::LocalHost, tcpPort);
+    if (!tcpOk)
+        qWarning() << "Frame server: TCP port" << tcpPort << tcpServer->errorString();
+
+    bool localOk = localServer->listen(localName);
+    if (!localOk && localServer->serverError() == QAbstractSocket::AddressInUseError
+        && !isLocalServerAlive(localName)) {
+        // Stale socket from a crashed run; a live one belongs to another instance
+        QLocalServer::removeServer(localName);
+        localOk = localServer->listen(localName);
+    }
+    if (!localOk)
+        qWarning() << "Frame server: local socket" << localName << localServer->errorString();
+
+    return tcpOk || localOk;
+}
+
+bool FrameServer::isLocalServerAlive(const QString &localName)
+{
+    QLocalSocket probe;
+    probe.connectToServer(localName);
+    const bool alive = probe.waitForConnected(kProbeTimeoutMs);
+    probe.abort();
+    return alive;
+}
+
+// -------------------- CONNECTIONS --------------------
+void FrameServer::acceptTcp()
+{
+    while (QTcpSocket *socket = tcpServer->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() { removeClient(socket); });
+        addClient(socket);
+    }
+}
+
+void FrameServer::acceptLocal()
+{
+    while (QLocalSocket *socket = localServer->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() { removeClient(socket); });
+        addClient(socket);
+    }
+}
+
+void FrameServer::addClient(QIODevice *device)
+{
+    Client *client = new Client;
+    client->device = device;
+    clients.append(client);
+
+    connect(device, &QIODevice::readyRead, this, [this, client]() { readCommands(client); });
+    device->write(kHello, sizeof(kHello) - 1);
+}
+
+void FrameServer::removeClient(QIODevice *device)
+{
+    for (int i = 0; i < clients.size(); i++) {
+        if (clients[i]->device == device) {
+            delete clients.takeAt(i);
+            device->disconnect(this);
+            device->deleteLater();
+            return;
+        }
+    }
+}
+
+void FrameServer::dropConnection(QIODevice *device)
+{
+    if (QTcpSocket *tcp = qobject_cast<QTcpSocket*>(device))
+        tcp->abort();
+    else if (QLocalSocket *local = qobject_cast<QLocalSocket*>(device))
+        local->abort();
+}
+
+// -------------------- FILTERS --------------------
+void FrameServer::readCommands(Client *client)
+{
+    client->commandBuffer.append(client->device->readAll());
+
+    int newlinePos;
+    while ((newlinePos = client->commandBuffer.indexOf('\n')) != -1) {
+        const QList<QByteArray> tokens = client->commandBuffer.left(newlinePos).simplified().split(' ');
+        client->commandBuffer.remove(0, newlinePos + 1);
+
+        const QByteArray command = tokens.value(0).toUpper();
+        if (command == "CLEAR") {
+            client->filters.clear();
+        } else if (command == "FILTER" && tokens.size() == 3) {
+            bool idOk = false;
+            bool maskOk = false;
+            quint32 id = tokens[1].toUInt(&idOk, 0);
+            quint32 mask = tokens[2].toUInt(&maskOk, 0);
+            if (!idOk || !maskOk)
+                continue;
+            // Every frame is matched against every filter, keep that bounded
+            const QPair<quint32, quint32> filter(id & mask, mask);
+            if (client->filters.contains(filter))
+                continue;
+            if (client->filters.size() >= kMaxFilters) {
+                qWarning() << "Frame server: client exceeded" << kMaxFilters << "filters, ignoring" << filter.first;
+                continue;
+            }
+            client->filters.append(filter);
+        }
+    }
+
+    if (client->commandBuffer.size() > kMaxCommandLength)
+        client->commandBuffer.clear();
+}
+
+bool FrameServer::matches(const Client *client, quint32 id)
+{
+    if (client->filters.isEmpty())
+        return true;
+    for (const auto &filter : client->filters) {
+        if ((id & filter.second) == filter.first)
+            return true;
+    }
+    return false;
+}
+
+// -------------------- FAN-OUT --------------------
+void FrameServer::publish(const QVector<CanMessage> &frames)
+{
+    if (clients.isEmpty() || frames.isEmpty())
+        return;
+
+    // Encode the batch once; each socket copies it into its own write buffer
+    QByteArray encoded(frames.size() * CanRecord::kSize, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar*>(encoded.data());
+    for (const CanMessage &msg : frames) {
+        CanRecord::write(out, msg);
+        out += CanRecord::kSize;
+    }
+
+    QByteArray selected;        // Scratch for filtered clients, allocated on first use
+    QList<QIODevice*> slowClients;
+    for (Client *client : std::as_const(clients)) {
+        QIODevice *device = client->device;
+        if (device->bytesToWrite() > kMaxBacklogBytes) {
+            slowClients.append(device);
+            continue;
+        }
+
+        if (client->filters.isEmpty()) {
+            device->write(encoded);
+            continue;
+        }
+
+        if (selected.isEmpty())
+            selected.resize(encoded.size());
+        char *selectedEnd = selected.data();
+        for (int i = 0; i < frames.size(); i++) {
+            if (matches(client, frames[i].id)) {
+                memcpy(selectedEnd, encoded.constData() + i * CanRecord::kSize, CanRecord::kSize);
+                selectedEnd += CanRecord::kSize;
+            }
+        }
+        if (selectedEnd != selected.constData())
+            device->write(selected.constData(), selectedEnd - selected.constData());
+    }
+
+    for (QIODevice *device : std::as_const(slowClients)) {
+        qWarning() << "Frame server: dropping slow client";
+        removeClient(device);
+        dropConnection(device);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef FRAMESERVER_H
+#define FRAMESERVER_H
+
+#include "canmessage.h"
+
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+class QIODevice;
+class QTcpServer;
+class QLocalServer;
+
+// Streams received frames to local subscribers over TCP (127.0.0.1) and a
+// local socket, so several bench tools can share the one open bus.
+//
+// Protocol:
+//   server -> client: "CANEMU01" once, then fixed 24-byte records (canrecord.h)
+//   client -> server: text lines
+//     "FILTER <id> <mask>"  add a filter, frame passes if (id & mask) == (filter & mask);
+//                           at most kMaxFilters per client, further ones are ignored
+//     "CLEAR"               remove all filters (everything passes)
+//
+// Each batch is encoded once. Every client's socket still copies what it is
+// sent into its own write buffer, and filtered clients get their matching
+// records gathered into a scratch buffer first, so the memory cost per client
+// is bounded by kMaxBacklogBytes: clients that fall further behind are dropped
+// instead of letting their backlog grow or slowing the ingest path.
+class FrameServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const quint16 kDefaultTcpPort = 29536;
+    static const qint64 kMaxBacklogBytes = 4 * 1024 * 1024;
+    static const int kMaxFilters = 32;
+
+    explicit FrameServer(QObject *parent = nullptr);
+    ~FrameServer();
+
+    bool listen(quint16 tcpPort = kDefaultTcpPort, const QString &localName = "can_emulator");
+    int clientCount() const { return clients.size(); }
+
+public slots:
+    void publish(const QVector<CanMessage> &frames);
+
+private slots:
+    void acceptTcp();
+    void acceptLocal();
+
+private:
+    struct Client {
+        QIODevice *device;
+        QVector<QPair<quint32, quint32>> filters; // (id, mask)
+        QByteArray commandBuffer;
+    };
+
+    void addClient(QIODevice *device);
+    void removeClient(QIODevice *device);
+    void readCommands(Client *client);
+    static bool matches(const Client *client, quint32 id);
+    static void dropConnection(QIODevice *device);
+    static bool isLocalServerAlive(const QString &localName);
+
+    QTcpServer *tcpServer;
+    QLocalServer *localServer;
+    QList<Client*> clients;
+};
+
+#endif // FRAMESERVER_H
@@ -0,0 +1,165 @@
+#include "frametablemodel.h"
+#include "captureclock.h"
+#include "capturepipeline.h"
+#include "framefilter.h"
+#include "payloaddelegate.h"
+
+#include <QColor>
+#include <QDateTime>
+
+namespace {
+
+const QColor kTxColor("#60A5FA");
+const QColor kRxColor("#34D399");
+const QColor kIdColor("#FBBF24");
+
+} // namespace
+
+FrameTableModel::FrameTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , relativeTime(false)
+    , startNs(0)
+{
+    rows.reserve(CapturePipeline::kMaxFrames);
+    nextRows.reserve(CapturePipeline::kMaxFrames);
+}
+
+// -------------------- FORMATTING --------------------
+QString FrameTableModel::formatCanId(quint32 id)
+{
+    return QString("0x%1").arg(id, 7, 16, QChar('0')).toUpper();
+}
+
+QString FrameTableModel::formatTimestamp(quint64 timestampNs, bool relative, quint64 startNs)
+{
+    if (relative) {
+        // Relative to the start of the capture: seconds with microseconds
+        qint64 offset = qint64(timestampNs) - qint64(startNs);
+        QString sign = offset < 0 ? "-" : "+";
+        quint64 magnitude = quint64(qAbs(offset));
+        return QString("%1%2.%3").arg(sign).arg(magnitude / 1000000000ULL)
+                                 .arg((magnitude % 1000000000ULL) / 1000, 6, 10, QChar('0'));
+    }
+
+    // Absolute wall-clock time with microseconds
+    quint64 epochNs = CaptureClock::toEpochNs(timestampNs);
+    QDateTime time = QDateTime::fromMSecsSinceEpoch(qint64(epochNs / 1000000));
+    return time.toString("HH:mm:ss.zzz") + QString("%1").arg((epochNs / 1000) % 1000, 3, 10, QChar('0'));
+}
+
+// -------------------- REFRESH --------------------
+void FrameTableModel::refresh(const CapturePipeline &pipeline, const FrameFilter &filter)
+{
+    const QVector<CanMessage> &frames = pipeline.frames();
+    nextRows.resize(0);
+    for (int i = 0; i < frames.size(); i++) {
+        if (filter.matches(frames[i].id))
+            nextRows.append(Row{frames[i], pipeline.changedMask(i)});
+    }
+
+    // Rows only change content, the view keeps its scroll position and
+    // repaints just what is on screen
+    const int oldCount = rows.size();
+    const int newCount = nextRows.size();
+    if (newCount > oldCount) {
+        beginInsertRows(QModelIndex(), oldCount, newCount - 1);
+        rows.swap(nextRows);
+        endInsertRows();
+    } else if (newCount < oldCount) {
+        beginRemoveRows(QModelIndex(), newCount, oldCount - 1);
+        rows.swap(nextRows);
+        endRemoveRows();
+    } else {
+        rows.swap(nextRows);
+    }
+
+    const int changed = qMin(oldCount, newCount);
+    if (changed > 0)
+        emit dataChanged(index(0, 0), index(changed - 1, ColumnCount - 1));
+}
+
+void FrameTableModel::setRelativeTime(bool relative, quint64 start)
+{
+    if (relative == relativeTime && start == startNs)
+        return;
+    relativeTime = relative;
+    startNs = start;
+    if (!rows.isEmpty())
+        emit dataChanged(index(0, TimeColumn), index(rows.size() - 1, TimeColumn));
+}
+
+// -------------------- MODEL --------------------
+int FrameTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int FrameTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant FrameTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size())
+        return QVariant();
+
+    const Row &row = rows[index.row()];
+    const CanMessage &frame = row.frame;
+    const int column = index.column();
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (column) {
+        case TimeColumn: return formatTimestamp(frame.timestampNs, relativeTime, startNs);
+        case DirColumn: return frame.tx ? QStringLiteral("TX") : QStringLiteral("RX");
+        case IdColumn: return formatCanId(frame.id);
+        case DlcColumn: return int(frame.dlc);
+        }
+        break;
+
+    case Qt::TextAlignmentRole:
+        if (column != DataColumn)
+            return int(Qt::AlignCenter);
+        break;
+
+    case Qt::ForegroundRole:
+        if (column == DirColumn)
+            return frame.tx ? kTxColor : kRxColor;
+        if (column == IdColumn)
+            return kIdColor;
+        break;
+
+    case PayloadDelegate::PayloadRole:
+        // A remote frame's data bytes are leftovers, only its DLC means something
+        if (column == DataColumn && !frame.rtr)
+            return QByteArray(reinterpret_cast<const char*>(frame.data), frame.dlc);
+        break;
+
+    case PayloadDelegate::ChangedMaskRole:
+        if (column == DataColumn)
+            return uint(frame.rtr ? 0 : row.changedMask);
+        break;
+
+    case PayloadDelegate::RemoteRole:
+        if (column == DataColumn && frame.rtr)
+            return int(frame.dlc);
+        break;
+    }
+    return QVariant();
+}
+
+QVariant FrameTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case TimeColumn: return QStringLiteral("Time");
+    case DirColumn: return QStringLiteral("Dir");
+    case IdColumn: return QStringLiteral("ID");
+    case DlcColumn: return QStringLiteral("DLC");
+    case DataColumn: return QStringLiteral("Data");
+    }
+    return QVariant();
+}
@@ -0,0 +1,51 @@
+#ifndef FRAMETABLEMODEL_H
+#define FRAMETABLEMODEL_H
+
+#include "canmessage.h"
+
+#include <QAbstractTableModel>
+#include <QVector>
+
+class CapturePipeline;
+class FrameFilter;
+
+// Rows of the CAN monitor: time, direction, ID, DLC and payload of the
+// frames in the pipeline's store that pass the filter, newest first.
+//
+// refresh() copies at most CapturePipeline::kMaxFrames frames into a buffer
+// that is reused between refreshes; text is only built in data(), so only
+// the rows on screen are ever formatted. The payload column carries raw
+// bytes for PayloadDelegate.
+class FrameTableModel : public QAbstractTableModel
+{
+public:
+    enum Column { TimeColumn, DirColumn, IdColumn, DlcColumn, DataColumn, ColumnCount };
+
+    explicit FrameTableModel(QObject *parent = nullptr);
+
+    void refresh(const CapturePipeline &pipeline, const FrameFilter &filter);
+
+    // Time column: wall clock, or seconds since startNs (capture clock)
+    void setRelativeTime(bool relative, quint64 startNs);
+
+    static QString formatCanId(quint32 id);
+    static QString formatTimestamp(quint64 timestampNs, bool relative, quint64 startNs);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Row {
+        CanMessage frame;
+        quint8 changedMask;     // Bit i = data[i] changed
+    };
+
+    QVector<Row> rows;
+    QVector<Row> nextRows;      // Filled by refresh(), then swapped in
+    bool relativeTime;
+    quint64 startNs;
+};
+
+#endif // FRAMETABLEMODEL_H
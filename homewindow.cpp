@@ -1,17 +1,36 @@
 #include "homewindow.h"
 #include "./ui_homewindow.h"
 #include "mainwindow.h"
+#include "portscanner.h"
+#include "serialtransport.h"
+#include "frameserver.h"
 
 #include <QPropertyAnimation>
-#include <QSerialPortInfo>
+#include <QThread>
+#include <QTimer>
 #include <QMessageBox>
 #include <QDebug>
 
+#ifdef Q_OS_LINUX
+#include "socketcantransport.h"
+#endif
+
+// Reopen retries after the port reappeared: 250 ms doubling up to 4 s,
+// then wait for the next hot-plug event
+static const int kReconnectFirstDelayMs = 250;
+static const int kReconnectMaxDelayMs = 4000;
+static const int kMaxReconnectAttempts = 8;
+
 HomeWindow::HomeWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::HomeWindow)
     , sidebarVisible(true)
     , serial(new QSerialPort(this))
+    , serialTransport(new SerialTransport(serial, this))
+    , transport(serialTransport)
+    , frameServer(new FrameServer(this))
+    , scanThread(new QThread(this))
+    , reconnectTimer(new QTimer(this))
 {
     ui->setupUi(this);
     ui->stackedWidget->setCurrentIndex(0);
@@ -28,9 +47,21 @@ HomeWindow::HomeWindow(QWidget *parent)
     connect(ui->toggleSidebarButton, &QPushButton::clicked, this, &HomeWindow::toggleSidebar);
 
     // ------------------------------
-    // Populate COM port dropdown
+    // Populate COM port dropdown (scanned in the background)
     // ------------------------------
-    refreshComPorts();
+    ui->labelComPort->clear();
+    ui->labelComPort->addItem("Scanning COM ports...");
+    ui->labelComPort->setItemData(0, true, Qt::UserRole - 1); // Mark as non-selectable
+
+    PortScanner *scanner = new PortScanner();
+    scanner->moveToThread(scanThread);
+    connect(scanThread, &QThread::started, scanner, &PortScanner::start);
+    connect(scanThread, &QThread::finished, scanner, &QObject::deleteLater);
+    connect(scanner, &PortScanner::portsChanged, this, &HomeWindow::refreshComPorts);
+    scanThread->start(QThread::LowPriority);
+
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, &HomeWindow::tryReconnect);
 
     // Populate baud rates with placeholders
     ui->labelBaud->clear();
@@ -39,6 +70,22 @@ HomeWindow::HomeWindow(QWidget *parent)
     ui->labelBaud->addItems({"9600", "115200", "500000"});
     ui->labelBaud->setCurrentIndex(0); // Set placeholder as selected
 
+    // Emulated frames need bridge firmware with framed records (bridgeprotocol.h),
+    // older firmware misreads them; nothing on the wire tells the two apart
+    txProtocolCombo = new QComboBox(this);
+    txProtocolCombo->addItem("Requests only (any firmware)");
+    txProtocolCombo->addItem("Framed TX (0xA5 firmware)");
+    txProtocolCombo->setToolTip("Framed TX is required for emulated nodes on the UART bridge");
+    ui->horizontalLayout_3->addWidget(txProtocolCombo);
+    connect(txProtocolCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        serialTransport->setTxProtocol(index == 1 ? SerialTransport::TxProtocol::Framed
+                                                  : SerialTransport::TxProtocol::RequestsOnly);
+        session.setSetting("txProtocol", index);
+    });
+
+    // Frames are captured from startup, the monitor page only shows them
+    pipeline.setTransport(serialTransport);
+
     // ------------------------------
     // Connect Buttons for navigation
     // ------------------------------
@@ -57,6 +104,8 @@ HomeWindow::HomeWindow(QWidget *parent)
     // ------------------------------
      connect(ui->connectButton, &QPushButton::clicked, this, &HomeWindow::connectSerial);
      connect(ui->disconnectButton, &QPushButton::clicked, this, &HomeWindow::disconnectSerial);
+     connect(serial, &QSerialPort::errorOccurred, this, &HomeWindow::handleSerialError);
+     connect(serialTransport, &CanTransport::statusChanged, this, &HomeWindow::handleTransportStatus);
 
     // Test buttons (for design)
     //connect(ui->connectButton, &QPushButton::clicked, this, &HomeWindow::testConnect);
@@ -74,6 +123,13 @@ HomeWindow::HomeWindow(QWidget *parent)
 
 HomeWindow::~HomeWindow()
 {
+    scanThread->quit();
+    scanThread->wait();
+
+    // Before the session and pipeline members go: the monitor joins its
+    // export/import workers, which use the session
+    delete monitorPage;
+
     if (serial->isOpen())
         serial->close();
     delete ui;
@@ -120,26 +176,77 @@ void HomeWindow::toggleSidebar()
 // ------------------------------
 // Refresh COM ports
 // ------------------------------
-void HomeWindow::refreshComPorts()
+void HomeWindow::refreshComPorts(const QStringList &names, const QStringList &descriptions)
 {
+    // Keep the user's selection across hot-plug updates
+    QString selected = ui->labelComPort->currentIndex() > 0 ? ui->labelComPort->currentText() : preferredPortName;
+
     ui->labelComPort->clear();
 
     // Add a placeholder for "Select COM Port"
     ui->labelComPort->addItem("Select COM Port");
     ui->labelComPort->setItemData(0, true, Qt::UserRole - 1); // Mark as non-selectable
 
-    const auto ports = QSerialPortInfo::availablePorts();
-    if (ports.isEmpty()) {
+    if (names.isEmpty()) {
         ui->labelComPort->addItem("No COM ports detected");
         ui->labelComPort->setItemData(ui->labelComPort->count() - 1, true, Qt::UserRole - 1); // Mark as non-selectable
     } else {
         // Add the available COM ports
-        for (const auto &port : ports)
-            ui->labelComPort->addItem(port.portName(), port.description());
+        for (int i = 0; i < names.size(); i++)
+            ui->labelComPort->addItem(names[i], descriptions.value(i));
     }
 
-    // Set the placeholder as the selected item initially
-    ui->labelComPort->setCurrentIndex(0);
+    // Restore the previous port, otherwise select the placeholder
+    int index = selected.isEmpty() ? -1 : ui->labelComPort->findText(selected);
+    ui->labelComPort->setCurrentIndex(index > 0 ? index : 0);
+
+    // The lost device is back: reconnect automatically, unless a retry
+    // chain is already running
+    if (!reconnectPortName.isEmpty() && names.contains(reconnectPortName) && !reconnectTimer->isActive()) {
+        reconnectAttempts = 0;
+        tryReconnect();
+    }
+}
+
+// ------------------------------
+// Services started after the first frame
+// ------------------------------
+void HomeWindow::startServices()
+{
+    // Both block for a while (server probe, session header walk), so they
+    // run once the window is on screen instead of delaying its first paint
+    if (servicesStarted) return;
+    servicesStarted = true;
+
+    // Share captured frames with local subscribers
+    frameServer->listen();
+    pipeline.setFrameServer(frameServer);
+
+    // Restore the previous session and keep recording into it
+    QString sessionError;
+    if (session.open(SessionStore::defaultPath(), CapturePipeline::kMaxFrames, &sessionError)) {
+        const SessionStore::Restored &restored = session.restored();
+        preferredPortName = restored.settings.value("portName").toString();
+        int baudIndex = ui->labelBaud->findText(restored.settings.value("baudRate").toString());
+        if (baudIndex > 0)
+            ui->labelBaud->setCurrentIndex(baudIndex);
+        txProtocolCombo->setCurrentIndex(restored.settings.value("txProtocol").toInt());
+
+        // The port scan may have finished first
+        int portIndex = preferredPortName.isEmpty() ? -1 : ui->labelComPort->findText(preferredPortName);
+        if (portIndex > 0 && ui->labelComPort->currentIndex() <= 0)
+            ui->labelComPort->setCurrentIndex(portIndex);
+
+        if (restored.totalFrames > 0)
+            statusBar()->showMessage(QString("Restored session: %1 frames in %2 ms")
+                                         .arg(restored.totalFrames)
+                                         .arg(restored.elapsedUs / 1000.0, 0, 'f', 1), 5000);
+        pipeline.setSessionStore(&session);
+    } else {
+        // Runs without a session, e.g. while another instance records into it
+        qWarning() << "Session not restored:" << sessionError;
+        statusBar()->showMessage("Session not recorded: " + sessionError, 5000);
+    }
 }
 
 // ------------------------------
@@ -150,14 +257,39 @@ void HomeWindow::connectSerial()
     QString portName = ui->labelComPort->currentText();
     if (portName == "No COM ports detected") return;
 
-    serial->setPortName(portName);
-    serial->setBaudRate(ui->labelBaud->currentText().toInt());
-    serial->setDataBits(QSerialPort::Data8);
-    serial->setParity(QSerialPort::NoParity);
-    serial->setStopBits(QSerialPort::OneStop);
-    serial->setFlowControl(QSerialPort::NoFlowControl);
+    bool opened = false;
+    QString error;
+
+#ifdef Q_OS_LINUX
+    if (SocketCanTransport::isCanInterface(portName)) {
+        // Bitrate is configured on the interface (ip link), not here
+        if (!socketCan) {
+            socketCan = new SocketCanTransport(this);
+            connect(socketCan, &CanTransport::statusChanged, this, &HomeWindow::handleTransportStatus);
+        }
+        opened = socketCan->open(portName);
+        error = socketCan->errorString();
+        transport = socketCan;
+    } else
+#endif
+    {
+        serial->setPortName(portName);
+        serial->setBaudRate(ui->labelBaud->currentText().toInt());
+        serial->setDataBits(QSerialPort::Data8);
+        serial->setParity(QSerialPort::NoParity);
+        serial->setStopBits(QSerialPort::OneStop);
+        serial->setFlowControl(QSerialPort::NoFlowControl);
+
+        serialTransport->resetBuffer();
+        opened = serial->open(QIODevice::ReadWrite);
+        error = serial->errorString();
+        transport = serialTransport;
+    }
+
+    if (opened) {
+        session.setSetting("portName", portName);
+        session.setSetting("baudRate", ui->labelBaud->currentText());
 
-    if (serial->open(QIODevice::ReadWrite)) {
         // Update status bar
         statusBar()->setStyleSheet("color: green;");
         statusBar()->showMessage("Connected to " + portName);
@@ -171,13 +303,12 @@ void HomeWindow::connectSerial()
         ui->disconnectButton->setEnabled(true);
         ui->disconnectButton->setStyleSheet("");
 
-        if (monitorPage)
-            monitorPage->updateSerialStatus();
+        pipeline.setTransport(transport);
 
     } else {
         statusBar()->setStyleSheet("color: red;");
-        statusBar()->showMessage("Connection Failed: " + serial->errorString());
-        QMessageBox::critical(this, "Connection Failed", serial->errorString());
+        statusBar()->showMessage("Connection Failed: " + error);
+        QMessageBox::critical(this, "Connection Failed", error);
 
         ui->statusLabel->setText("🔴 Status: Error");
         ui->statusLabel->setStyleSheet("color: red; font-weight: bold; font-size: 14px;");
@@ -189,27 +320,118 @@ void HomeWindow::connectSerial()
 // ------------------------------
 void HomeWindow::disconnectSerial()
 {
-    if (serial->isOpen()) {
-        QString portName = serial->portName();
-        serial->close();
+    bool reconnecting = !reconnectPortName.isEmpty();
+    reconnectPortName.clear();
+    reconnectTimer->stop();
+
+    if (transport->isOpen() || reconnecting || ui->disconnectButton->isEnabled()) {
+        QString portName = transport->name();
+        closeTransport();
+        showDisconnected("Disconnected from " + portName);
+    }
+}
 
-        // Update status bar
-        statusBar()->setStyleSheet("color: red;");
-        statusBar()->showMessage("Disconnected from " + portName);
+void HomeWindow::showDisconnected(const QString &message)
+{
+    // Update status bar
+    statusBar()->setStyleSheet("color: red;");
+    statusBar()->showMessage(message);
 
-        // Update label
-        ui->statusLabel->setText("🔴 Status: Disconnected");
-        ui->statusLabel->setStyleSheet("color: red; font-weight: bold; font-size: 14px;");
+    // Update label
+    ui->statusLabel->setText("🔴 Status: Disconnected");
+    ui->statusLabel->setStyleSheet("color: red; font-weight: bold; font-size: 14px;");
 
-        // Enable/disable buttons
-        ui->connectButton->setEnabled(true);
-        ui->disconnectButton->setEnabled(false);
-        ui->disconnectButton->setStyleSheet("background-color: #cccccc; color: #666666;");
+    // Enable/disable buttons
+    ui->connectButton->setEnabled(true);
+    ui->disconnectButton->setEnabled(false);
+    ui->disconnectButton->setStyleSheet("background-color: #cccccc; color: #666666;");
 
-        if (monitorPage)
-            monitorPage->updateSerialStatus();
+    if (monitorPage)
+        monitorPage->updateSerialStatus();
+}
 
+void HomeWindow::closeTransport()
+{
+    closingTransport = true;
+    serial->close();
+    serialTransport->resetBuffer();
+
+#ifdef Q_OS_LINUX
+    if (socketCan)
+        socketCan->close();
+#endif
+    closingTransport = false;
+}
+
+// A transport closed by itself (SocketCAN interface down, fatal read
+// error): without this the Disconnect button stays enabled for nothing
+void HomeWindow::handleTransportStatus()
+{
+    if (closingTransport || sender() != transport || transport->isOpen())
+        return;
+
+    // A lost serial port is handled by the reconnect logic instead
+    if (!reconnectPortName.isEmpty() || !ui->disconnectButton->isEnabled())
+        return;
+
+    QString message = "Connection to " + transport->name() + " lost";
+    if (!transport->errorString().isEmpty())
+        message += ": " + transport->errorString();
+    showDisconnected(message);
+}
+
+// ------------------------------
+// Auto reconnect after a transient disconnect
+// ------------------------------
+void HomeWindow::handleSerialError(QSerialPort::SerialPortError error)
+{
+    // ResourceError is raised when the device disappears (USB unplug/glitch)
+    if (error != QSerialPort::ResourceError || !serial->isOpen())
+        return;
+
+    reconnectPortName = serial->portName();
+    serial->close();
+
+    statusBar()->setStyleSheet("color: orange;");
+    statusBar()->showMessage("Lost " + reconnectPortName + ", waiting for it to come back...");
+
+    ui->statusLabel->setText("🟠 Status: Reconnecting");
+    ui->statusLabel->setStyleSheet("color: orange; font-weight: bold; font-size: 14px;");
+
+    // Captured frames stay in the monitor page, only the link state changes
+    if (monitorPage)
+        monitorPage->updateSerialStatus();
+}
+
+void HomeWindow::tryReconnect()
+{
+    if (reconnectPortName.isEmpty() || serial->isOpen())
+        return;
+
+    // Baud rate, parity, etc. are kept by the QSerialPort object across close()
+    serial->setPortName(reconnectPortName);
+    serialTransport->resetBuffer();
+    if (!serial->open(QIODevice::ReadWrite)) {
+        // The node may exist before udev fixed its permissions, retry with
+        // backoff; after that only a new hot-plug event restarts the chain
+        if (++reconnectAttempts < kMaxReconnectAttempts) {
+            int delay = qMin(kReconnectFirstDelayMs << (reconnectAttempts - 1), kReconnectMaxDelayMs);
+            reconnectTimer->start(delay);
+        }
+        return;
     }
+    reconnectTimer->stop();
+    reconnectAttempts = 0;
+
+    statusBar()->setStyleSheet("color: green;");
+    statusBar()->showMessage("Reconnected to " + reconnectPortName);
+    reconnectPortName.clear();
+
+    ui->statusLabel->setText("🔵 Status: Connected");
+    ui->statusLabel->setStyleSheet("color: #82C0E9; font-weight: bold; font-size: 14px;");
+
+    if (monitorPage)
+        monitorPage->updateSerialStatus();
 }
 
 // ------------------------------
@@ -260,7 +482,7 @@ void HomeWindow::showTransmitPage() {
 void HomeWindow::showMonitorPage()
 {
     if (!monitorPage) {
-        monitorPage = new MainWindow(this, serial);
+        monitorPage = new MainWindow(&pipeline, this);
         ui->stackedWidget->addWidget(monitorPage);
     }
     ui->stackedWidget->setCurrentWidget(monitorPage);
@@ -1,9 +1,20 @@
 #ifndef HOMEWINDOW_H
 #define HOMEWINDOW_H
 
+#include "capturepipeline.h"
 #include "mainwindow.h"
+#include "sessionstore.h"
 #include <QMainWindow>
 #include <QSerialPort>
+#include <QStringList>
+
+class QComboBox;
+class QThread;
+class QTimer;
+class CanTransport;
+class SerialTransport;
+class SocketCanTransport;
+class FrameServer;
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class HomeWindow; }
@@ -17,11 +28,18 @@ public:
     explicit HomeWindow(QWidget *parent = nullptr);
     ~HomeWindow();
 
+public slots:
+    void startServices();      // Frame server and session restore, once the window is shown
+
 private slots:
     void toggleSidebar();      // Toggle sidebar visibility
-    void refreshComPorts();    // Populate COM port dropdown
+    void refreshComPorts(const QStringList &names, const QStringList &descriptions); // Populate COM port dropdown
     void connectSerial();      // Connect to selected serial port
     void disconnectSerial();   // Disconnect serial port
+    void handleSerialError(QSerialPort::SerialPortError error); // Detect unplugged device
+    void tryReconnect();       // Reopen a port lost unexpectedly
+    void closeTransport();     // Close whichever transport is open
+    void handleTransportStatus(); // Transport opened or closed on its own
 
     // Test slots
     void testConnect();
@@ -36,9 +54,25 @@ private slots:
     void showTransmitPage();
 
 private:
+    void showDisconnected(const QString &message);
+
     Ui::HomeWindow *ui;
     bool sidebarVisible;       // Sidebar state
     QSerialPort *serial;       // Serial port object
+    SerialTransport *serialTransport;  // Frame I/O over the UART bridge
+    SocketCanTransport *socketCan = nullptr; // Native SocketCAN (Linux, created on demand)
+    CanTransport *transport;   // Active transport
+    FrameServer *frameServer;  // Streams frames to other local tools
+    QComboBox *txProtocolCombo; // SerialTransport::TxProtocol, chosen to match the firmware
+    QThread *scanThread;       // Background port enumeration
+    QString reconnectPortName; // Port lost unexpectedly, reopened when it reappears
+    QTimer *reconnectTimer;    // Pending retry of tryReconnect, backs off
+    int reconnectAttempts = 0;
+    bool closingTransport = false; // Close requested here, not by the transport
+    bool servicesStarted = false; // startServices() ran
+    QString preferredPortName; // Port of the restored session, selected once it shows up
+    SessionStore session;      // Frames and settings persisted across restarts
+    CapturePipeline pipeline;  // Ingest and frame store, declared after its session
     MainWindow* monitorPage = nullptr;
 };
 
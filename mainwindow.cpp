@@ -1,4 +1,13 @@
 #include "mainwindow.h"
+#include "traceio.h"
+#include "captureanalyzer.h"
+#include "emulationengine.h"
+#include "framefilter.h"
+#include "frametablemodel.h"
+#include "sessionstore.h"
+#include "payloaddelegate.h"
+#include "triggercapture.h"
+#include <QFontMetrics>
 #include <QHeaderView>
 #include <QSerialPort>
 #include <QSerialPortInfo>
@@ -16,31 +25,126 @@
 #include <QTableWidgetItem>
 #include <QComboBox>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QDialog>
+#include <QFile>
+#include <QDateTime>
+#include <QThread>
+#include <QSharedPointer>
+#include <QStringList>
 #include <algorithm>
-#include <QDebug>
+#include <cstring>
+#include <utility>
+
+static const char *kTraceFileFilter = "candump log (*.log);;Vector ASC (*.asc);;CSV (*.csv)";
 
 // -------------------- CONSTRUCTOR --------------------
-MainWindow::MainWindow(QWidget *parent, QSerialPort* serialPort)
+MainWindow::MainWindow(CapturePipeline *capturePipeline, QWidget *parent)
     : QMainWindow(parent)
-    , serial(serialPort)
     , isConnected(false)
     , busLoad(0.0)
-    , errorCount(0)
+    , cancelWorkers(false)
+    , pipeline(capturePipeline)
+    , emulation(capturePipeline->emulation())
+    , trigger(capturePipeline->trigger())
 {
     setupUI();
     setDarkTheme();
 
-    if (serial) {
-        connect(serial, &QSerialPort::readyRead, this, &MainWindow::handleSerialData);
-    }
+    // The pipeline ingests with or without this view, it only observes
+    connect(pipeline, &CapturePipeline::framesChanged, this, &MainWindow::scheduleTableUpdate);
+    connect(pipeline, &CapturePipeline::eventsChanged, this, &MainWindow::updateStatus);
+    connect(pipeline, &CapturePipeline::transportChanged, this, &MainWindow::updateSerialStatus);
+
+    connect(trigger, &TriggerCapture::stateChanged, this, &MainWindow::updateTriggerStatus);
+    connect(trigger, &TriggerCapture::captureSaved, this, [this](const QString &path, int frames) {
+        triggerLabel->setText(QString("Saved %1 frames to %2").arg(frames).arg(path));
+    });
+    connect(trigger, &TriggerCapture::captureFailed, this, [this](const QString &error) {
+        triggerLabel->setText("Save failed: " + error);
+    });
+
+    // Frame bursts and emulated traffic refresh the table at most this often
+    refreshTimer = new QTimer(this);
+    refreshTimer->setSingleShot(true);
+    refreshTimer->setInterval(50);
+    connect(refreshTimer, &QTimer::timeout, this, &MainWindow::updateTable);
+    connect(refreshTimer, &QTimer::timeout, this, &MainWindow::updateEmulationLabel);
+
+    restoreSessionSettings();
 
     // Initial status
     updateSerialStatus();
+    updateStatus();
+    updateTable();
+}
+
+// -------------------- SESSION --------------------
+void MainWindow::restoreSessionSettings()
+{
+    SessionStore *session = pipeline->sessionStore();
+    if (!session) return;
+    importBtn->setEnabled(true);
+
+    const QVariantMap &settings = session->restored().settings;
+    filterCheckbox->setChecked(settings.value("filterEnabled").toBool());
+    filterInput->setText(settings.value("filterText").toString());
+    timeModeCombo->setCurrentIndex(settings.value("timeMode").toInt());
+
+    // The transmit schedule is restored loaded but stopped
+    const QString script = settings.value("emulationScript").toString();
+    if (!script.isEmpty() && emulation->loadScript(script))
+        updateEmulationLabel();
+
+    connect(filterCheckbox, &QCheckBox::stateChanged, this, &MainWindow::saveSessionSettings);
+    connect(filterInput, &QLineEdit::textChanged, this, &MainWindow::saveSessionSettings);
+    connect(timeModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::saveSessionSettings);
+}
+
+void MainWindow::saveSessionSettings()
+{
+    SessionStore *session = pipeline->sessionStore();
+    if (!session) return;
+
+    session->setSetting("filterEnabled", filterCheckbox->isChecked());
+    session->setSetting("filterText", filterInput->text());
+    session->setSetting("timeMode", timeModeCombo->currentIndex());
+    session->setSetting("emulationScript", emulation->script());
+}
+
+void MainWindow::showSessionStatistics()
+{
+    SessionStore *session = pipeline->sessionStore();
+    if (!session) return;
+
+    CaptureAnalysis analysis;
+    analysis.ids = session->statistics();
+    for (const IdStatistics &stats : std::as_const(analysis.ids))
+        analysis.frames += stats.count;
+    showAnalysis(analysis, "Session Statistics");
 }
 
 // -------------------- DESTRUCTOR --------------------
 MainWindow::~MainWindow()
 {
+    // Workers use the session store and the files picked here; none may
+    // outlive the window
+    cancelWorkers = true;
+    for (QThread *worker : std::as_const(workers)) {
+        worker->wait();
+        delete worker;
+    }
+}
+
+// Background jobs, tracked so the destructor can cancel and join them
+void MainWindow::startWorker(QThread *worker, QThread::Priority priority)
+{
+    workers.append(worker);
+    connect(worker, &QThread::finished, this, [this, worker]() {
+        workers.removeOne(worker);
+        worker->deleteLater();
+    });
+    worker->start(priority);
 }
 
 // -------------------- SETUP UI --------------------
@@ -90,113 +194,12 @@ void MainWindow::setupUI()
 // -------------------- DARK THEME --------------------
 void MainWindow::setDarkTheme()
 {
-    setStyleSheet(R"(
-        QMainWindow {
-            background-color: #0F172A;
-        }
-        QWidget {
-            background-color: #0F172A;
-            color: #F1F5F9;
-            font-family: Arial;
-            font-size: 13px;
-        }
-        QGroupBox {
-            background-color: #1E293B;
-            border: 1px solid #334155;
-            border-radius: 8px;
-            margin-top: 10px;
-            padding: 15px;
-            font-weight: bold;
-            font-size: 16px;
-        }
-        QGroupBox::title {
-            subcontrol-origin: margin;
-            left: 10px;
-            padding: 0 5px;
-            color: #60A5FA;
-        }
-        QLineEdit, QTextEdit {
-            background-color: #334155;
-            border: 1px solid #475569;
-            border-radius: 6px;
-            padding: 8px;
-            color: #F1F5F9;
-        }
-        QLineEdit:focus, QTextEdit:focus {
-            border: 2px solid #3B82F6;
-        }
-        QPushButton {
-            background-color: #3B82F6;
-            color: white;
-            border: none;
-            border-radius: 6px;
-            padding: 10px 20px;
-            font-weight: bold;
-            font-size: 13px;
-        }
-        QPushButton:hover {
-            background-color: #2563EB;
-        }
-        QPushButton:pressed {
-            background-color: #1D4ED8;
-        }
-        QPushButton:disabled {
-            background-color: #475569;
-            color: #94A3B8;
-        }
-        QTableWidget {
-            background-color: #0F172A;
-            border: 1px solid #334155;
-            border-radius: 6px;
-            gridline-color: #334155;
-        }
-        QTableWidget::item {
-            padding: 8px;
-            border-bottom: 1px solid #334155;
-        }
-        QTableWidget::item:selected {
-            background-color: #1E293B;
-        }
-        QHeaderView::section {
-            background-color: #334155;
-            color: #F1F5F9;
-            padding: 10px;
-            border: none;
-            font-weight: bold;
-        }
-        QCheckBox {
-            spacing: 8px;
-        }
-        QCheckBox::indicator {
-            width: 18px;
-            height: 18px;
-            border-radius: 3px;
-            border: 2px solid #475569;
-            background-color: #334155;
-        }
-        QCheckBox::indicator:checked {
-            background-color: #3B82F6;
-            border-color: #3B82F6;
-        }
-        QComboBox {
-            background-color: #334155;
-            border: 1px solid #475569;
-            border-radius: 6px;
-            padding: 8px;
-            color: #F1F5F9;
-        }
-        QComboBox:focus {
-            border: 2px solid #3B82F6;
-        }
-        QComboBox::drop-down {
-            border: none;
-        }
-        QComboBox QAbstractItemView {
-            background-color: #334155;
-            color: #F1F5F9;
-            selection-background-color: #3B82F6;
-        }
-    )");
+    // Loaded from the resource once and shared by every monitor page
+    static const QString theme = [] {
+        QFile file(":/resources/monitor.qss");
+        return file.open(QFile::ReadOnly) ? QString::fromUtf8(file.readAll()) : QString();
+    }();
+    setStyleSheet(theme);
 }
 
 // -------------------- STATUS BAR --------------------
@@ -280,10 +283,82 @@ QGroupBox* MainWindow::createTransmitPanel()
     connect(filterInput, &QLineEdit::textChanged, this, &MainWindow::updateTable);
     layout->addWidget(filterInput);
 
+    layout->addWidget(createEmulationSection());
+    layout->addWidget(createTriggerSection());
+
     layout->addStretch();
     return group;
 }
 
+// -------------------- EMULATION SECTION --------------------
+QWidget* MainWindow::createEmulationSection()
+{
+    QWidget *section = new QWidget();
+    QVBoxLayout *layout = new QVBoxLayout(section);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *emulationTitle = new QLabel("🤖 Node Emulation");
+    emulationTitle->setStyleSheet("font-weight: bold; margin-top: 20px; padding-top: 15px; border-top: 1px solid #334155;");
+    layout->addWidget(emulationTitle);
+
+    QPushButton *loadBtn = new QPushButton("📂 Load Script");
+    connect(loadBtn, &QPushButton::clicked, this, &MainWindow::loadEmulationScript);
+    layout->addWidget(loadBtn);
+
+    emulationCheckbox = new QCheckBox("Enable emulated nodes");
+    emulationCheckbox->setEnabled(false);
+    connect(emulationCheckbox, &QCheckBox::stateChanged, this, &MainWindow::toggleEmulation);
+    layout->addWidget(emulationCheckbox);
+
+    emulationLabel = new QLabel("No script loaded");
+    emulationLabel->setStyleSheet("color: #94A3B8;");
+    layout->addWidget(emulationLabel);
+
+    return section;
+}
+
+// -------------------- TRIGGER SECTION --------------------
+QWidget* MainWindow::createTriggerSection()
+{
+    QWidget *section = new QWidget();
+    QVBoxLayout *layout = new QVBoxLayout(section);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    QLabel *triggerTitle = new QLabel("🎯 Triggered Capture");
+    triggerTitle->setStyleSheet("font-weight: bold; margin-top: 20px; padding-top: 15px; border-top: 1px solid #334155;");
+    layout->addWidget(triggerTitle);
+
+    triggerInput = new QLineEdit();
+    triggerInput->setPlaceholderText("id 0x1900141 b0&0x80=0x80; id 0x7DF");
+    layout->addWidget(triggerInput);
+
+    preTriggerSpin = new QDoubleSpinBox();
+    preTriggerSpin->setRange(0.0, 60.0);
+    preTriggerSpin->setValue(5.0);
+    preTriggerSpin->setSuffix(" s before");
+
+    postTriggerSpin = new QDoubleSpinBox();
+    postTriggerSpin->setRange(0.0, 60.0);
+    postTriggerSpin->setValue(5.0);
+    postTriggerSpin->setSuffix(" s after");
+
+    QHBoxLayout *windowLayout = new QHBoxLayout();
+    windowLayout->addWidget(preTriggerSpin);
+    windowLayout->addWidget(postTriggerSpin);
+    layout->addLayout(windowLayout);
+
+    triggerCheckbox = new QCheckBox("Arm trigger");
+    connect(triggerCheckbox, &QCheckBox::stateChanged, this, &MainWindow::toggleTrigger);
+    layout->addWidget(triggerCheckbox);
+
+    triggerLabel = new QLabel("Not armed");
+    triggerLabel->setStyleSheet("color: #94A3B8;");
+    triggerLabel->setWordWrap(true);
+    layout->addWidget(triggerLabel);
+
+    return section;
+}
+
 // -------------------- MONITOR PANEL --------------------
 QGroupBox* MainWindow::createMonitorPanel()
 {
@@ -302,28 +377,71 @@ QGroupBox* MainWindow::createMonitorPanel()
     )");
     connect(clearBtn, &QPushButton::clicked, this, &MainWindow::clearFrames);
 
+    QPushButton *exportBtn = new QPushButton("💾 Export");
+    exportBtn->setMaximumWidth(110);
+    exportBtn->setStyleSheet(clearBtn->styleSheet());
+    connect(exportBtn, &QPushButton::clicked, this, &MainWindow::exportFrames);
+
+    importBtn = new QPushButton("📥 Import");
+    importBtn->setMaximumWidth(110);
+    importBtn->setStyleSheet(clearBtn->styleSheet());
+    importBtn->setEnabled(false);       // Needs a session to import into
+    connect(importBtn, &QPushButton::clicked, this, &MainWindow::importTrace);
+
+    QPushButton *convertBtn = new QPushButton("🔄 Convert");
+    convertBtn->setMaximumWidth(120);
+    convertBtn->setStyleSheet(clearBtn->styleSheet());
+    connect(convertBtn, &QPushButton::clicked, this, &MainWindow::convertTrace);
+
+    timeModeCombo = new QComboBox();
+    timeModeCombo->addItem("Absolute time");
+    timeModeCombo->addItem("Relative time");
+    connect(timeModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::updateTable);
+
+    QPushButton *analyzeBtn = new QPushButton("📈 Analyze");
+    analyzeBtn->setMaximumWidth(120);
+    analyzeBtn->setStyleSheet(clearBtn->styleSheet());
+    connect(analyzeBtn, &QPushButton::clicked, this, &MainWindow::analyzeCapture);
+
+    QPushButton *sessionBtn = new QPushButton("📋 Session");
+    sessionBtn->setMaximumWidth(120);
+    sessionBtn->setStyleSheet(clearBtn->styleSheet());
+    connect(sessionBtn, &QPushButton::clicked, this, &MainWindow::showSessionStatistics);
+
     QHBoxLayout *headerLayout = new QHBoxLayout();
+    headerLayout->addWidget(timeModeCombo);
     headerLayout->addStretch();
+    headerLayout->addWidget(sessionBtn);
+    headerLayout->addWidget(analyzeBtn);
+    headerLayout->addWidget(convertBtn);
+    headerLayout->addWidget(importBtn);
+    headerLayout->addWidget(exportBtn);
     headerLayout->addWidget(clearBtn);
     layout->addLayout(headerLayout);
 
-    table = new QTableWidget();
-    table->setColumnCount(5);
-    table->setHorizontalHeaderLabels({"Time", "Dir", "ID", "DLC", "Data"});
+    // Rows come from the model and are formatted only when painted
+    frameModel = new FrameTableModel(this);
+    table = new QTableView();
+    table->setModel(frameModel);
 
-    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    table->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Fixed);
+    // Widths from the longest text instead of ResizeToContents, which would
+    // format every row on each refresh
+    const QFontMetrics metrics(table->font());
+    table->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table->horizontalHeader()->resizeSection(0, metrics.horizontalAdvance("+000000.000000") + 24);
     table->horizontalHeader()->resizeSection(1, 60);
-    table->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    table->horizontalHeader()->setSectionResizeMode(3, QHeaderView::Fixed);
+    table->horizontalHeader()->resizeSection(2, metrics.horizontalAdvance("0X1FFFFFFF") + 24);
     table->horizontalHeader()->resizeSection(3, 60);
     table->horizontalHeader()->setSectionResizeMode(4, QHeaderView::Stretch);
 
     table->setEditTriggers(QAbstractItemView::NoEditTriggers);
     table->setSelectionBehavior(QAbstractItemView::SelectRows);
-    table->setWordWrap(true);
-    table->verticalHeader()->setDefaultSectionSize(40);
-    table->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table->setItemDelegateForColumn(FrameTableModel::DataColumn, new PayloadDelegate(table));
+
+    // Fixed row height: no per-row text layout on refresh
+    table->setWordWrap(false);
+    table->verticalHeader()->setDefaultSectionSize(32);
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
     layout->addWidget(table);
     return monitorGroup;
@@ -332,7 +450,7 @@ QGroupBox* MainWindow::createMonitorPanel()
 // -------------------- SERIAL STATUS --------------------
 void MainWindow::updateSerialStatus()
 {
-    if (serial && serial->isOpen()) {
+    if (pipeline->isConnected()) {
         isConnected = true;
         statusIndicator->setStyleSheet("color: #10B981; font-size: 20px;");
         statusLabel->setText("Connected");
@@ -343,6 +461,7 @@ void MainWindow::updateSerialStatus()
         statusLabel->setText("Disconnected");
         sendBtn->setEnabled(false);
     }
+    updateEmulationAvailability();
     updateStatus();
 }
 
@@ -363,186 +482,347 @@ void MainWindow::sendFrame()
         return;
     }
 
-    QByteArray payload(8, 0x00);
+    QByteArray payload = buildPayload();
 
-    if (serial && serial->isOpen()) {
-        QByteArray packet;
-        packet.append((canId >> 24) & 0xFF);
-        packet.append((canId >> 16) & 0xFF);
-        packet.append((canId >> 8) & 0xFF);
-        packet.append(canId & 0xFF);
+    CanMessage request;
+    request.id = canId;
+    request.extended = canId > CanMessage::kMaxStandardId;
+    request.dlc = quint8(payload.size());
+    memcpy(request.data, payload.constData(), request.dlc);
 
-        serial->write(packet);
-        serial->flush();
-
-        qDebug() << "Sent CAN ID to UART:" << QString("0x%1").arg(canId, 7, 16, QChar('0')).toUpper();
-        qDebug() << "Raw bytes:" << packet.toHex(' ').toUpper();
+    if (!pipeline->sendRequest(request)) {
+        CanTransport *transport = pipeline->transport();
+        QMessageBox::warning(this, "Send Request", transport ? transport->errorString() : "Not connected");
     }
+}
 
-    CANFrame frame;
-    frame.timestamp = QTime::currentTime().toString("HH:mm:ss.zzz");
-    frame.canId = QString("0x%1").arg(canId, 7, 16, QChar('0')).toUpper();
-    frame.data = payload.toHex(' ').toUpper();
-    frame.dlc = payload.size();
-    frame.direction = "TX";
+// -------------------- EMULATION --------------------
+void MainWindow::loadEmulationScript()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Load Emulation Script", QString(),
+                                                "Emulation scripts (*.canemu *.txt);;All files (*)");
+    if (path.isEmpty()) return;
 
-    canFrames.prepend(frame);
-    if (canFrames.size() > 50)
-        canFrames.resize(50);
+    QString error;
+    if (!emulation->loadScriptFile(path, &error)) {
+        QMessageBox::warning(this, "Emulation Script", error);
+        return;
+    }
 
-    updateTable();
+    updateEmulationLabel();
+    updateEmulationAvailability();
+    saveSessionSettings();
 }
 
-// -------------------- CLEAR FRAMES --------------------
-void MainWindow::clearFrames()
+void MainWindow::updateEmulationAvailability()
 {
-    canFrames.clear();
-    updateTable();
+    // The UART bridge only sends arbitrary frames in framed TX mode
+    const bool canTransmit = pipeline->canTransmitFrames();
+    emulationCheckbox->setEnabled(canTransmit && emulation->ruleCount() > 0);
+    emulationCheckbox->setToolTip(isConnected && !canTransmit
+                                      ? "This transport only sends requests. Select Framed TX if the bridge firmware supports it."
+                                      : QString());
+
+    if (!canTransmit && emulation->isRunning()) {
+        emulation->stop();
+        QSignalBlocker blocker(emulationCheckbox);
+        emulationCheckbox->setChecked(false);
+    }
 }
 
-// -------------------- FILTER --------------------
-void MainWindow::updateFilter(int)
+void MainWindow::updateEmulationLabel()
 {
-    filterInput->setEnabled(filterCheckbox->isChecked());
-    updateTable();
+    QString text = QString("%1 nodes, %2 rules").arg(emulation->nodeCount()).arg(emulation->ruleCount());
+
+    // Runs on the GUI thread, so show how well it keeps its schedule
+    const EmulationEngine::LatenessStats &lateness = emulation->latenessStats();
+    if (emulation->isRunning() && lateness.ticks > 0) {
+        text += QString("\nworst tick %1 ms late, %2 of %3 over %4 ms")
+                    .arg(lateness.worstNs / 1e6, 0, 'f', 2)
+                    .arg(lateness.lateTicks)
+                    .arg(lateness.ticks)
+                    .arg(EmulationEngine::kLatenessBudgetNs / 1e6, 0, 'f', 0);
+    }
+    emulationLabel->setText(text);
 }
 
-// -------------------- SERIAL DATA --------------------
-void MainWindow::handleSerialData()
+void MainWindow::toggleEmulation(int)
 {
-    if (!serial) return;
-
-    static QByteArray serialBuffer;
-    serialBuffer.append(serial->readAll());
+    if (emulationCheckbox->isChecked() && pipeline->canTransmitFrames())
+        emulation->start();
+    else
+        emulation->stop();
+    updateEmulationLabel();
+}
 
-    qDebug() << "========== NEW SERIAL DATA ==========";
-    qDebug() << "Buffer size:" << serialBuffer.size() << "bytes";
-    qDebug() << "Buffer content:" << QString(serialBuffer);
+// -------------------- TRIGGERED CAPTURE --------------------
+void MainWindow::toggleTrigger(int)
+{
+    if (!triggerCheckbox->isChecked()) {
+        trigger->disarm();
+        return;
+    }
 
-    int newlinePos;
-    while ((newlinePos = serialBuffer.indexOf('\n')) != -1)
-    {
-        QByteArray lineData = serialBuffer.left(newlinePos);
-        serialBuffer.remove(0, newlinePos + 1);
+    QString directory = QFileDialog::getExistingDirectory(this, "Triggered Capture - Output Folder");
+    QString error;
+    if (directory.isEmpty()
+        || !trigger->arm(triggerInput->text(), preTriggerSpin->value(), postTriggerSpin->value(), directory, &error)) {
+        if (!error.isEmpty())
+            QMessageBox::warning(this, "Triggered Capture", error);
+        QSignalBlocker blocker(triggerCheckbox);
+        triggerCheckbox->setChecked(false);
+    }
+}
 
-        QString line = QString::fromUtf8(lineData).trimmed();
+void MainWindow::updateTriggerStatus()
+{
+    const bool idle = trigger->state() == TriggerCapture::State::Idle;
+    triggerInput->setEnabled(idle);
+    preTriggerSpin->setEnabled(idle);
+    postTriggerSpin->setEnabled(idle);
+
+    switch (trigger->state()) {
+    case TriggerCapture::State::Idle:
+        triggerLabel->setText("Not armed");
+        break;
+    case TriggerCapture::State::Armed:
+        if (trigger->savesInProgress() == 0)
+            triggerLabel->setText("Armed, waiting for trigger...");
+        break;
+    case TriggerCapture::State::Recording:
+        triggerLabel->setText("Triggered, recording post-trigger window...");
+        break;
+    }
+}
 
-        qDebug() << "Processing line:" << line;
-        qDebug() << "Line length:" << line.length();
+// -------------------- EXPORT / IMPORT / CONVERT --------------------
+void MainWindow::exportFrames()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Export Frames", QString(), kTraceFileFilter);
+    if (path.isEmpty()) return;
+
+    if (SessionStore *store = pipeline->sessionStore()) {
+        // The whole history lives in the session file, stream it from there
+        auto error = QSharedPointer<QString>::create();
+        QThread *worker = QThread::create([this, store, path, error]() {
+            store->exportTo(path, error.data(), &cancelWorkers);
+        });
+        connect(worker, &QThread::finished, this, [this, path, error]() {
+            if (error->isEmpty())
+                QMessageBox::information(this, "Export Frames", "Written " + path);
+            else
+                QMessageBox::warning(this, "Export Frames", *error);
+        });
+        startWorker(worker);
+        return;
+    }
 
-        if (line.isEmpty()) {
-            qDebug() << "⚠️ Skipping empty line";
-            continue;
-        }
+    TraceFormat format = traceFormatForPath(path);
+    QFile file(path);
+    if (format == TraceFormat::Unknown || !file.open(QFile::WriteOnly | QFile::Truncate)) {
+        QMessageBox::warning(this, "Export Frames",
+                             format == TraceFormat::Unknown ? "Unsupported trace format" : file.errorString());
+        return;
+    }
 
-        if (!line.startsWith("[ID 0x")) {
-            qDebug() << "⚠️ Line doesn't start with '[ID 0x' - skipping";
-            continue;
-        }
+    // Without a session only the monitor is available; newest first, traces are chronological
+    const QVector<CanMessage> &frames = pipeline->frames();
+    TraceWriter writer(&file, format);
+    for (int i = frames.size() - 1; i >= 0; i--) {
+        CanMessage msg = frames[i];
+        msg.timestampNs = CaptureClock::toEpochNs(msg.timestampNs);
+        writer.write(msg);
+    }
 
-        CANFrame frame;
-        frame.timestamp = QTime::currentTime().toString("HH:mm:ss.zzz");
-        frame.direction = "RX";
+    if (!writer.finish())
+        QMessageBox::warning(this, "Export Frames", file.errorString());
+}
 
-        int idStart = line.indexOf("0x");
-        int idEnd = line.indexOf("]", idStart);
+void MainWindow::importTrace()
+{
+    SessionStore *store = pipeline->sessionStore();
+    if (!store) return;
 
-        if (idStart == -1 || idEnd == -1) {
-            qDebug() << "❌ Failed to extract CAN ID - malformed line";
-            continue;
-        }
+    // Live frames would interleave with the imported history
+    if (pipeline->isConnected()) {
+        QMessageBox::warning(this, "Import Trace", "Disconnect before importing a trace.");
+        return;
+    }
 
-        frame.canId = line.mid(idStart, idEnd - idStart).toUpper();
-        qDebug() << "✅ Extracted CAN ID:" << frame.canId;
+    QString path = QFileDialog::getOpenFileName(this, "Import Trace", QString(), kTraceFileFilter);
+    if (path.isEmpty()) return;
 
-        int dataStart = idEnd + 1;
-        if (dataStart < line.length()) {
-            frame.data = line.mid(dataStart).trimmed();
-            qDebug() << "✅ Extracted data:" << frame.data;
-        } else {
-            frame.data = "No data";
-            qDebug() << "⚠️ No data after ] - setting to 'No data'";
-        }
+    if (QMessageBox::question(this, "Import Trace",
+                              "The imported trace replaces the current session. The current one is "
+                              "kept as a .1 backup next to the session file. Continue?")
+        != QMessageBox::Yes)
+        return;
 
-        frame.dlc = frame.data.length();
+    // Replaces the session history, the monitor is reloaded with its tail
+    auto recent = QSharedPointer<QVector<CanMessage>>::create();
+    auto error = QSharedPointer<QString>::create();
+    QThread *worker = QThread::create([this, store, path, recent, error]() {
+        store->importFrom(path, recent.data(), error.data(), &cancelWorkers);
+    });
+    connect(worker, &QThread::finished, this, [this, recent, error]() {
+        if (!error->isEmpty())
+            QMessageBox::warning(this, "Import Trace", *error);
+        else
+            pipeline->replaceFrames(*recent);
+        pipeline->setRecordingPaused(false);
+        importBtn->setEnabled(true);
+    });
+    importBtn->setEnabled(false);
+    pipeline->setRecordingPaused(true);
+    startWorker(worker);
+}
 
-        qDebug() << "📦 Complete Frame:";
-        qDebug() << "  Timestamp:" << frame.timestamp;
-        qDebug() << "  Direction:" << frame.direction;
-        qDebug() << "  CAN ID:" << frame.canId;
-        qDebug() << "  Data:" << frame.data;
-        qDebug() << "  DLC:" << frame.dlc;
+void MainWindow::convertTrace()
+{
+    QString input = QFileDialog::getOpenFileName(this, "Convert Trace - Input", QString(), kTraceFileFilter);
+    if (input.isEmpty()) return;
+    QString output = QFileDialog::getSaveFileName(this, "Convert Trace - Output", QString(), kTraceFileFilter);
+    if (output.isEmpty()) return;
+
+    // Runs off the GUI thread, large captures can take a while
+    auto error = QSharedPointer<QString>::create();
+    QThread *worker = QThread::create([this, input, output, error]() {
+        TraceConverter::convert(input, output, error.data(), &cancelWorkers);
+    });
+    connect(worker, &QThread::finished, this, [this, output, error]() {
+        if (error->isEmpty())
+            QMessageBox::information(this, "Convert Trace", "Written " + output);
+        else
+            QMessageBox::warning(this, "Convert Trace", *error);
+    });
+    startWorker(worker);
+}
 
-        canFrames.prepend(frame);
-        if (canFrames.size() > 50)
-            canFrames.resize(50);
+// -------------------- OFFLINE ANALYSIS --------------------
+void MainWindow::analyzeCapture()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Analyze Capture", QString(), kTraceFileFilter);
+    if (path.isEmpty()) return;
+
+    CaptureAnalyzer::Options options;
+    if (filterCheckbox->isChecked())
+        options.idFilter = filterInput->text();
+    options.cancel = &cancelWorkers;
+
+    // Decoding fans out over all cores, keep the GUI thread free meanwhile
+    auto analysis = QSharedPointer<CaptureAnalysis>::create();
+    auto error = QSharedPointer<QString>::create();
+    QThread *worker = QThread::create([path, options, analysis, error]() {
+        CaptureAnalyzer::analyze(path, options, analysis.data(), error.data());
+    });
+    connect(worker, &QThread::finished, this, [this, analysis, error]() {
+        if (error->isEmpty())
+            showAnalysis(*analysis);
+        else
+            QMessageBox::warning(this, "Analyze Capture", *error);
+    });
+    startWorker(worker);
+}
 
-        qDebug() << "✅ Frame added. Total frames:" << canFrames.size();
+void MainWindow::showAnalysis(const CaptureAnalysis &analysis, const QString &title)
+{
+    QDialog *dialog = new QDialog(this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->setWindowTitle(title);
+    dialog->resize(800, 500);
+
+    QVBoxLayout *layout = new QVBoxLayout(dialog);
+
+    double seconds = qMax<qint64>(analysis.elapsedMs, 1) / 1000.0;
+    QString text = QString("%1 frames, %2 IDs").arg(analysis.frames).arg(analysis.ids.size());
+    if (analysis.bytes > 0) {
+        // Offline analysis of a trace file
+        text += QString(", %1 filter matches, %2 anomalies, %3 skipped lines\n"
+                        "%4 MB in %5 s (%6 MB/s) - %7 chunks on %8 threads")
+                    .arg(analysis.filterMatches)
+                    .arg(analysis.anomalies.size())
+                    .arg(analysis.skippedLines)
+                    .arg(analysis.bytes / 1e6, 0, 'f', 1)
+                    .arg(seconds, 0, 'f', 2)
+                    .arg(analysis.bytes / 1e6 / seconds, 0, 'f', 1)
+                    .arg(analysis.chunks)
+                    .arg(analysis.threads);
+    }
+    QLabel *summary = new QLabel(text);
+    layout->addWidget(summary);
+
+    QTableWidget *statsTable = new QTableWidget(analysis.ids.size(), 6);
+    statsTable->setHorizontalHeaderLabels({"ID", "Frames", "Mean period (ms)", "Min (ms)", "Max (ms)", "DLC changes"});
+    statsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    statsTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+
+    for (int row = 0; row < analysis.ids.size(); row++) {
+        const IdStatistics &stats = analysis.ids[row];
+        statsTable->setItem(row, 0, new QTableWidgetItem(FrameTableModel::formatCanId(stats.id)));
+        statsTable->setItem(row, 1, new QTableWidgetItem(QString::number(stats.count)));
+        statsTable->setItem(row, 2, new QTableWidgetItem(QString::number(stats.meanPeriodMs(), 'f', 3)));
+        statsTable->setItem(row, 3, new QTableWidgetItem(QString::number(stats.minPeriodNs / 1e6, 'f', 3)));
+        statsTable->setItem(row, 4, new QTableWidgetItem(QString::number(stats.maxPeriodNs / 1e6, 'f', 3)));
+        statsTable->setItem(row, 5, new QTableWidgetItem(QString::number(stats.dlcChanges)));
+        if (!stats.matchesFilter) {
+            for (int col = 0; col < 6; col++)
+                statsTable->item(row, col)->setForeground(QColor("#64748B"));
+        }
     }
+    layout->addWidget(statsTable);
 
-    qDebug() << "========== END SERIAL DATA ==========";
-    qDebug() << "Remaining buffer size:" << serialBuffer.size();
-    qDebug() << "";
+    dialog->show();
+}
 
+// -------------------- CLEAR FRAMES --------------------
+void MainWindow::clearFrames()
+{
+    pipeline->clear();
+}
+
+// -------------------- FILTER --------------------
+void MainWindow::updateFilter(int)
+{
+    filterInput->setEnabled(filterCheckbox->isChecked());
     updateTable();
 }
 
 // -------------------- UPDATE TABLE --------------------
 void MainWindow::updateTable()
 {
-    QVector<CANFrame> frames = canFrames;
-
-    if (filterCheckbox->isChecked() && !filterInput->text().isEmpty()) {
-        QString filterText = filterInput->text().toLower();
-        frames.erase(std::remove_if(frames.begin(), frames.end(),
-                                    [&filterText](const CANFrame& f) {
-                                        return !f.canId.toLower().contains(filterText);
-                                    }), frames.end());
-    }
-
-    monitorGroup->setTitle(QString("📊 CAN Monitor (%1 frames)").arg(frames.size()));
-
-    table->setRowCount(frames.size());
-
-    for (int row = 0; row < frames.size(); row++) {
-        const CANFrame& frame = frames[row];
-
-        QTableWidgetItem *timeItem = new QTableWidgetItem(frame.timestamp);
-        timeItem->setTextAlignment(Qt::AlignCenter);
-        table->setItem(row, 0, timeItem);
-
-        QTableWidgetItem *dirItem = new QTableWidgetItem(frame.direction);
-        dirItem->setTextAlignment(Qt::AlignCenter);
-        dirItem->setForeground(frame.direction == "TX" ? QColor("#60A5FA") : QColor("#34D399"));
-        table->setItem(row, 1, dirItem);
+    const FrameFilter filter(filterCheckbox->isChecked() ? filterInput->text() : QString());
+    frameModel->setRelativeTime(timeModeCombo->currentIndex() == 1, pipeline->captureStartNs());
+    frameModel->refresh(*pipeline, filter);
 
-        QTableWidgetItem *idItem = new QTableWidgetItem(frame.canId);
-        idItem->setTextAlignment(Qt::AlignCenter);
-        idItem->setForeground(QColor("#FBBF24"));
-        table->setItem(row, 2, idItem);
-
-        QTableWidgetItem *dlcItem;
-        if (frame.direction == "RX") {
-            dlcItem = new QTableWidgetItem("N/A");
-        } else {
-            dlcItem = new QTableWidgetItem(QString::number(frame.dlc));
-        }
-        dlcItem->setTextAlignment(Qt::AlignCenter);
-        table->setItem(row, 3, dlcItem);
+    monitorGroup->setTitle(QString("📊 CAN Monitor (%1 frames)").arg(frameModel->rowCount()));
+}
 
-        QTableWidgetItem *dataItem = new QTableWidgetItem(frame.data);
-        dataItem->setTextAlignment(Qt::AlignLeft | Qt::AlignVCenter);
-        dataItem->setFlags(dataItem->flags() & ~Qt::ItemIsEditable);
-        table->setItem(row, 4, dataItem);
-    }
+void MainWindow::scheduleTableUpdate()
+{
+    if (!refreshTimer->isActive())
+        refreshTimer->start();
+}
 
-    table->resizeRowsToContents();
-    table->resizeColumnToContents(4);
+// -------------------- TIMESTAMPS --------------------
+QString MainWindow::formatTimestamp(quint64 timestampNs) const
+{
+    return FrameTableModel::formatTimestamp(timestampNs, timeModeCombo->currentIndex() == 1,
+                                            pipeline->captureStartNs());
 }
 
 // -------------------- UPDATE STATUS --------------------
 void MainWindow::updateStatus()
 {
     busLoadValue->setText(QString("%1%").arg(busLoad, 0, 'f', 1));
-    errorValue->setText(QString::number(errorCount));
+    const AnomalyDetector &detector = pipeline->detector();
+    errorValue->setText(QString::number(detector.totalEvents()));
+
+    // Most recent events, newest first
+    const BusEventLog &events = detector.events();
+    QStringList lines;
+    for (int i = events.size() - 1; i >= 0 && lines.size() < 10; i--) {
+        const BusEvent &event = events.at(i);
+        lines.append(formatTimestamp(event.timestampNs) + "  " + event.description());
+    }
+    errorValue->setToolTip(lines.join('\n'));
 }
@@ -9,42 +9,55 @@
 #include <QPushButton>
 #include <QLineEdit>
 #include <QTextEdit>
-#include <QTableWidget>
+#include <QTableView>
 #include <QCheckBox>
 #include <QGroupBox>
 #include <QTimer>
 #include <QTime>
 #include <QVector>
 #include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QHash>
+#include <QThread>
 
-#include <QSerialPort>
-#include <QSerialPortInfo>
+#include <atomic>
 
-class QSerialPort;
+#include "canmessage.h"
+#include "captureanalyzer.h"
+#include "captureclock.h"
+#include "cantransport.h"
+#include "capturepipeline.h"
 
-struct CANFrame {
-    QString timestamp;
-    QString canId;
-    QString data;
-    int dlc;
-    QString direction; // "TX" or "RX"
-};
+class EmulationEngine;
+class FrameTableModel;
+class TriggerCapture;
 
+// Monitor page: a view of the CapturePipeline plus the controls driving it
+// (requests, emulation, triggered capture, export/import).
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget* parent = nullptr, QSerialPort* serialPort = nullptr);
+    explicit MainWindow(CapturePipeline *capturePipeline, QWidget* parent = nullptr);
     ~MainWindow();
 
 public slots:
     void sendFrame();
     void clearFrames();
     void updateFilter(int state);
-    void handleSerialData();
     void updateTable();
     void updateSerialStatus();
+    void loadEmulationScript();
+    void toggleEmulation(int state);
+    void toggleTrigger(int state);
+    void updateTriggerStatus();
+    void exportFrames();
+    void importTrace();
+    void convertTrace();
+    void analyzeCapture();
+    void showSessionStatistics();
+    void saveSessionSettings();
 
 private:
     void setupUI();
@@ -52,7 +65,16 @@ private:
     QWidget* createStatusBar();
     QGroupBox* createTransmitPanel();
     QGroupBox* createMonitorPanel();
+    QWidget* createEmulationSection();
+    QWidget* createTriggerSection();
+    void restoreSessionSettings();
+    void updateEmulationAvailability();
+    void updateEmulationLabel();
     void updateStatus();
+    void scheduleTableUpdate();
+    void startWorker(QThread *worker, QThread::Priority priority = QThread::InheritPriority);
+    QString formatTimestamp(quint64 timestampNs) const;
+    void showAnalysis(const CaptureAnalysis &analysis, const QString &title = "Capture Analysis");
     QByteArray buildPayload(); // returns 8 reserved bytes for request
 
     // UI Components
@@ -61,22 +83,35 @@ private:
     QLabel *busLoadValue;
     QLabel *errorValue;
     QPushButton *sendBtn;
+    QPushButton *importBtn;
     QLineEdit *canIdInput;
     QTextEdit *canDataInput;
     QCheckBox *filterCheckbox;
     QLineEdit *filterInput;
-    QTableWidget *table;
+    QTableView *table;
+    FrameTableModel *frameModel;
     QGroupBox *monitorGroup;
-    QTimer *timer;
+    QTimer *refreshTimer;
     QComboBox *requestCombo;
+    QComboBox *timeModeCombo;
+    QCheckBox *emulationCheckbox;
+    QLabel *emulationLabel;
+    QLineEdit *triggerInput;
+    QDoubleSpinBox *preTriggerSpin;
+    QDoubleSpinBox *postTriggerSpin;
+    QCheckBox *triggerCheckbox;
+    QLabel *triggerLabel;
 
     // Data
     bool isConnected;
-    QVector<CANFrame> canFrames;
     double busLoad;
-    int errorCount;
 
-    QSerialPort* serial;
+    QList<QThread*> workers;            // Running background jobs, see startWorker()
+    std::atomic<bool> cancelWorkers;    // Set when the window goes away
+
+    CapturePipeline *pipeline;      // Frames, events and transmit path, not owned
+    EmulationEngine *emulation;     // Owned by the pipeline
+    TriggerCapture *trigger;        // Owned by the pipeline
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,140 @@
+#include "payloaddelegate.h"
+
+#include <QApplication>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QPainter>
+
+namespace {
+
+const int kMaxBytes = 8;
+const int kMargin = 6;          // Left/right margin of the cell
+const int kCellGap = 2;         // Between hex cells
+const int kSectionGap = 12;     // Between the hex and ASCII sections
+
+const QColor kChangedBackground("#B45309");
+const QColor kChangedText("#FDE68A");
+const QColor kAsciiText("#94A3B8");
+
+} // namespace
+
+PayloadDelegate::PayloadDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , cacheValid(false)
+    , cellWidth(0)
+    , charWidth(0)
+    , textHeight(0)
+{
+}
+
+// -------------------- GLYPH CACHE --------------------
+void PayloadDelegate::ensureCache(const QFont &viewFont) const
+{
+    if (cacheValid && viewFont == cachedFont)
+        return;
+
+    // Same size as the rest of the row, but fixed pitch so the cells line up
+    QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    if (viewFont.pointSizeF() > 0)
+        font.setPointSizeF(viewFont.pointSizeF());
+    else
+        font.setPixelSize(viewFont.pixelSize());
+
+    static const char kHexDigits[] = "0123456789ABCDEF";
+    for (int b = 0; b < 256; b++) {
+        const char hex[3] = { kHexDigits[b >> 4], kHexDigits[b & 0xF], 0 };
+        hexText[b].setText(QString::fromLatin1(hex));
+        hexText[b].setTextFormat(Qt::PlainText);
+        hexText[b].prepare(QTransform(), font);
+
+        const QChar ascii = (b >= 0x20 && b < 0x7F) ? QChar(b) : QChar('.');
+        asciiText[b].setText(QString(ascii));
+        asciiText[b].setTextFormat(Qt::PlainText);
+        asciiText[b].prepare(QTransform(), font);
+    }
+    noDataText.setText("No data");
+    noDataText.setTextFormat(Qt::PlainText);
+    noDataText.prepare(QTransform(), font);
+    for (int dlc = 0; dlc <= kMaxBytes; dlc++) {
+        remoteText[dlc].setText(QString("Remote frame, DLC %1").arg(dlc));
+        remoteText[dlc].setTextFormat(Qt::PlainText);
+        remoteText[dlc].prepare(QTransform(), font);
+    }
+
+    QFontMetrics metrics(font);
+    cellWidth = metrics.horizontalAdvance("00") + 6;
+    charWidth = metrics.horizontalAdvance('W');
+    textHeight = metrics.height();
+
+    fixedFont = font;
+    cachedFont = viewFont;
+    cacheValid = true;
+}
+
+// -------------------- PAINT --------------------
+void PayloadDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    QStyleOptionViewItem opt(option);
+    initStyleOption(&opt, index);
+
+    // Background and selection exactly like the other columns
+    QStyle *style = opt.widget ? opt.widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, opt.widget);
+
+    ensureCache(opt.font);
+
+    const QByteArray payload = index.data(PayloadRole).toByteArray();
+    const uint changed = index.data(ChangedMaskRole).toUInt();
+    const QColor textColor = (opt.state & QStyle::State_Selected)
+                                 ? opt.palette.color(QPalette::HighlightedText)
+                                 : opt.palette.color(QPalette::Text);
+
+    const QRect rect = opt.rect;
+    const int y = rect.top() + (rect.height() - textHeight) / 2;
+    int x = rect.left() + kMargin;
+
+    painter->save();
+    painter->setClipRect(rect);
+    painter->setFont(fixedFont);
+
+    const QVariant remoteDlc = index.data(RemoteRole);
+    if (remoteDlc.isValid() || payload.isEmpty()) {
+        painter->setPen(kAsciiText);
+        painter->drawStaticText(x, y, remoteDlc.isValid() ? remoteText[qBound(0, remoteDlc.toInt(), kMaxBytes)]
+                                                          : noDataText);
+        painter->restore();
+        return;
+    }
+
+    const int count = qMin(int(payload.size()), kMaxBytes);
+    for (int i = 0; i < count; i++) {
+        const uchar b = uchar(payload[i]);
+        if (changed & (1u << i)) {
+            painter->fillRect(QRect(x, y - 1, cellWidth, textHeight + 2), kChangedBackground);
+            painter->setPen(kChangedText);
+        } else {
+            painter->setPen(textColor);
+        }
+        painter->drawStaticText(x + 3, y, hexText[b]);
+        x += cellWidth + kCellGap;
+    }
+
+    // ASCII always starts at the same column, whatever the DLC
+    x = rect.left() + kMargin + kMaxBytes * (cellWidth + kCellGap) + kSectionGap;
+    for (int i = 0; i < count; i++) {
+        const uchar b = uchar(payload[i]);
+        painter->setPen((changed & (1u << i)) ? kChangedText : kAsciiText);
+        painter->drawStaticText(x, y, asciiText[b]);
+        x += charWidth;
+    }
+
+    painter->restore();
+}
+
+QSize PayloadDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &) const
+{
+    ensureCache(option.font);
+
+    return QSize(2 * kMargin + kMaxBytes * (cellWidth + kCellGap) + kSectionGap + kMaxBytes * charWidth,
+                 textHeight + 8);
+}
@@ -0,0 +1,46 @@
+#ifndef PAYLOADDELEGATE_H
+#define PAYLOADDELEGATE_H
+
+#include <QFont>
+#include <QStaticText>
+#include <QStyledItemDelegate>
+
+// Paints a CAN payload as 8 fixed-width hex cells followed by its ASCII
+// rendering, highlighting the bytes that changed since the previous frame
+// with the same ID.
+//
+// The item carries the raw bytes (PayloadRole) and a bit mask of changed
+// bytes (ChangedMaskRole) instead of display text. Remote frames have no
+// payload and show their requested length (RemoteRole) instead. All 256 hex and ASCII
+// glyph runs are laid out once per font as QStaticText, so painting a row
+// is a handful of blits with no text shaping and the row height is fixed.
+class PayloadDelegate : public QStyledItemDelegate
+{
+public:
+    enum Role {
+        PayloadRole = Qt::UserRole,       // QByteArray, up to 8 bytes
+        ChangedMaskRole,                  // uint, bit i set if byte i changed
+        RemoteRole                        // int DLC, set for remote frames only
+    };
+
+    explicit PayloadDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+    void ensureCache(const QFont &viewFont) const;
+
+    mutable QFont cachedFont;   // View font the cache was built for
+    mutable QFont fixedFont;
+    mutable bool cacheValid;
+    mutable QStaticText hexText[256];
+    mutable QStaticText asciiText[256];
+    mutable QStaticText noDataText;
+    mutable QStaticText remoteText[9];   // "Remote frame, DLC n"
+    mutable int cellWidth;      // One hex byte including padding
+    mutable int charWidth;      // One ASCII character
+    mutable int textHeight;
+};
+
+#endif // PAYLOADDELEGATE_H
@@ -0,0 +1,158 @@
+#include "portscanner.h"
+
+#include <QSerialPortInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#ifdef Q_OS_LINUX
+#include "socketcantransport.h"
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+// Delay after a /dev change so udev can finish creating and chmod'ing nodes
+static const int kSettleDelayMs = 250;
+static const int kArphrdCan = 280; // ARPHRD_CAN in <linux/if_arp.h>
+#endif
+
+// Interval between hot-plug rescans without change notifications
+static const int kRescanIntervalMs = 2000;
+
+PortScanner::PortScanner(QObject *parent)
+    : QObject(parent)
+    , timer(new QTimer(this))
+    , watcher(nullptr)
+    , linkNotifier(nullptr)
+    , linkFd(-1)
+    , scanned(false)
+{
+#ifdef Q_OS_LINUX
+    timer->setSingleShot(true);
+    timer->setInterval(kSettleDelayMs);
+#else
+    timer->setInterval(kRescanIntervalMs);
+#endif
+    connect(timer, &QTimer::timeout, this, &PortScanner::rescan);
+}
+
+PortScanner::~PortScanner()
+{
+#ifdef Q_OS_LINUX
+    if (linkFd >= 0)
+        ::close(linkFd);
+#endif
+}
+
+void PortScanner::start()
+{
+    rescan();
+
+#ifdef Q_OS_LINUX
+    // Created here so the inotify notifier belongs to the worker thread
+    watcher = new QFileSystemWatcher(this);
+    watcher->addPath("/dev");
+    connect(watcher, &QFileSystemWatcher::directoryChanged, timer, QOverload<>::of(&QTimer::start));
+
+    if (!watchInterfaces()) {
+        // No link events: poll so can/vcan interfaces still come and go
+        timer->setSingleShot(false);
+        timer->setInterval(kRescanIntervalMs);
+        timer->start();
+    }
+#else
+    timer->start();
+#endif
+}
+
+// -------------------- SOCKETCAN INTERFACES --------------------
+bool PortScanner::watchInterfaces()
+{
+#ifdef Q_OS_LINUX
+    linkFd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (linkFd < 0)
+        return false;
+
+    sockaddr_nl addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind(linkFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(linkFd);
+        linkFd = -1;
+        return false;
+    }
+
+    linkNotifier = new QSocketNotifier(linkFd, QSocketNotifier::Read, this);
+    connect(linkNotifier, &QSocketNotifier::activated, this, [this]() { readInterfaceEvents(); });
+    return true;
+#else
+    return false;
+#endif
+}
+
+void PortScanner::readInterfaceEvents()
+{
+#ifdef Q_OS_LINUX
+    // Links of other types (Wi-Fi, docker veths) flap often, only CAN ones
+    // added, removed or brought up/down trigger a rescan
+    bool canChanged = false;
+    alignas(nlmsghdr) char buffer[8192];
+    for (;;) {
+        const ssize_t length = recv(linkFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length < 0 && errno == ENOBUFS) {
+            canChanged = true;  // Events were dropped, rescan to be sure
+            continue;
+        }
+        if (length <= 0)
+            break;
+
+        int remaining = int(length);
+        for (const nlmsghdr *msg = reinterpret_cast<const nlmsghdr*>(buffer); NLMSG_OK(msg, remaining);
+             msg = NLMSG_NEXT(msg, remaining)) {
+            if (msg->nlmsg_type != RTM_NEWLINK && msg->nlmsg_type != RTM_DELLINK)
+                continue;
+            const ifinfomsg *info = static_cast<const ifinfomsg*>(NLMSG_DATA(msg));
+            if (msg->nlmsg_len >= NLMSG_LENGTH(sizeof(ifinfomsg)) && info->ifi_type == kArphrdCan)
+                canChanged = true;
+        }
+    }
+
+    if (canChanged)
+        timer->start();
+#endif
+}
+
+void PortScanner::rescan()
+{
+    QStringList names;
+    QStringList descriptions;
+
+    const auto ports = QSerialPortInfo::availablePorts();
+    for (const auto &port : ports) {
+        names.append(port.portName());
+        descriptions.append(port.description());
+    }
+
+#ifdef Q_OS_LINUX
+    // CAN network interfaces (can0, vcan0, ...) are offered next to the UARTs
+    const QStringList interfaces = SocketCanTransport::availableInterfaces();
+    for (const QString &name : interfaces) {
+        names.append(name);
+        descriptions.append("SocketCAN");
+    }
+#endif
+
+    if (scanned && names == lastNames && descriptions == lastDescriptions)
+        return;
+
+    scanned = true;
+    lastNames = names;
+    lastDescriptions = descriptions;
+    emit portsChanged(names, descriptions);
+}
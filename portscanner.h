@@ -0,0 +1,47 @@
+#ifndef PORTSCANNER_H
+#define PORTSCANNER_H
+
+#include <QObject>
+#include <QStringList>
+
+class QTimer;
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+// Enumerates serial ports off the GUI thread. Lives in a worker thread owned
+// by HomeWindow and only reports when the set of ports actually changes.
+//
+// On Linux, hot-plug is detected by watching /dev through inotify
+// (QFileSystemWatcher) for serial ports and by listening for netlink link
+// events for SocketCAN interfaces (sysfs does not report new entries through
+// inotify), so nothing runs while the device set is stable. Other platforms,
+// and Linux without a netlink socket, fall back to a periodic rescan.
+class PortScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PortScanner(QObject *parent = nullptr);
+    ~PortScanner();
+
+public slots:
+    void start();   // Initial scan + hot-plug monitoring (worker thread)
+    void rescan();
+
+signals:
+    void portsChanged(const QStringList &names, const QStringList &descriptions);
+
+private:
+    bool watchInterfaces();
+    void readInterfaceEvents();
+
+    QTimer *timer;
+    QFileSystemWatcher *watcher;
+    QSocketNotifier *linkNotifier;
+    int linkFd;     // NETLINK_ROUTE socket subscribed to link changes
+    QStringList lastNames;
+    QStringList lastDescriptions;
+    bool scanned;
+};
+
+#endif // PORTSCANNER_H
@@ -0,0 +1,102 @@
+#include "serialtransport.h"
+
+#include <QSerialPort>
+
+SerialTransport::SerialTransport(QSerialPort *serialPort, QObject *parent)
+    : CanTransport(parent)
+    , serial(serialPort)
+    , protocol(TxProtocol::RequestsOnly)
+{
+    connect(serial, &QSerialPort::readyRead, this, &SerialTransport::readData);
+
+    // Queued: the port only reports closed once aboutToClose() returned
+    connect(serial, &QSerialPort::aboutToClose, this, &CanTransport::statusChanged, Qt::QueuedConnection);
+}
+
+bool SerialTransport::isOpen() const
+{
+    return serial->isOpen();
+}
+
+QString SerialTransport::name() const
+{
+    return serial->portName();
+}
+
+QString SerialTransport::errorString() const
+{
+    return serial->errorString();
+}
+
+void SerialTransport::resetBuffer()
+{
+    decoder.reset();
+    deviceClock.reset();
+}
+
+// -------------------- TRANSMIT --------------------
+void SerialTransport::setTxProtocol(TxProtocol txProtocol)
+{
+    if (txProtocol == protocol)
+        return;
+    protocol = txProtocol;
+    emit statusChanged();   // Frame transmit became (un)available
+}
+
+bool SerialTransport::writeFrames(const CanMessage *frames, int count)
+{
+    if (!serial->isOpen() || protocol != TxProtocol::Framed)
+        return false;
+
+    QByteArray packet(count * BridgeProtocol::kMaxTxRecordSize, Qt::Uninitialized);
+    int length = 0;
+    for (int i = 0; i < count; i++)
+        length += BridgeProtocol::encodeFrame(frames[i], packet.data() + length);
+    packet.truncate(length);
+
+    return serial->write(packet) == packet.size();
+}
+
+bool SerialTransport::sendRequest(const CanMessage &request)
+{
+    if (!serial->isOpen())
+        return false;
+
+    // Same encoding in both modes, framed firmware tells them apart by the sync byte
+    char packet[BridgeProtocol::kRequestSize];
+    BridgeProtocol::encodeRequest(request.id, packet);
+    return serial->write(packet, sizeof(packet)) == qint64(sizeof(packet));
+}
+
+// -------------------- RECEIVE --------------------
+void SerialTransport::readData()
+{
+    // Stamp the whole batch at byte arrival, before any parsing
+    const quint64 arrivalNs = CaptureClock::nowNs();
+
+    decoder.append(serial->readAll());
+
+    QVector<CanMessage> frames;
+    CanMessage msg;
+    quint64 deviceUs = 0;
+    BridgeLineDecoder::Status status;
+    while (decoder.next(&msg, &deviceUs, &status)) {
+        if (status == BridgeLineDecoder::Status::Error) {
+            // Deliver what came before so events stay in stream order
+            if (!frames.isEmpty()) {
+                emit framesReceived(frames);
+                frames.clear();
+            }
+            emit parseError(arrivalNs);
+            continue;
+        }
+
+        // Bridge timestamps are exact relative to each other, the host clock
+        // only anchors them
+        msg.timestampNs = deviceUs ? deviceClock.map(deviceUs * 1000, arrivalNs) : arrivalNs;
+        frames.append(msg);
+    }
+
+    if (!frames.isEmpty())
+        emit framesReceived(frames);
+}
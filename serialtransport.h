@@ -0,0 +1,53 @@
+#ifndef SERIALTRANSPORT_H
+#define SERIALTRANSPORT_H
+
+#include "bridgeprotocol.h"
+#include "cantransport.h"
+#include "captureclock.h"
+
+class QSerialPort;
+
+// CAN over the STM32 UART bridge.
+//
+// RX: ASCII lines "[ID 0x1900140] 11 22 33 ..." with an optional
+//     "t=<microseconds>" token carrying the bridge's own receive timestamp,
+//     decoded by BridgeLineDecoder (bridgeprotocol.h).
+// TX: requests as the bare 4-byte ID. Arbitrary frames (emulated traffic)
+//     need the framed record, which older firmware misreads, so they are
+//     only sent once the user selected TxProtocol::Framed.
+class SerialTransport : public CanTransport
+{
+    Q_OBJECT
+
+public:
+    enum class TxProtocol {
+        RequestsOnly,   // Any firmware: requests only, no frame transmit
+        Framed          // Firmware with 0xA5 framed records
+    };
+
+    explicit SerialTransport(QSerialPort *serialPort, QObject *parent = nullptr);
+
+    bool isOpen() const override;
+    QString name() const override;
+    QString errorString() const override;
+
+    bool canTransmitFrames() const override { return protocol == TxProtocol::Framed; }
+    bool writeFrames(const CanMessage *frames, int count) override;
+    bool sendRequest(const CanMessage &request) override;
+
+    void setTxProtocol(TxProtocol txProtocol);
+    TxProtocol txProtocol() const { return protocol; }
+
+    void resetBuffer(); // Drop a partially received line
+
+private slots:
+    void readData();
+
+private:
+    QSerialPort *serial;
+    BridgeLineDecoder decoder;
+    DeviceClockSync deviceClock;
+    TxProtocol protocol;
+};
+
+#endif // SERIALTRANSPORT_H
@@ -0,0 +1,620 @@
+#include "sessionstore.h"
+#include "canrecord.h"
+#include "captureclock.h"
+#include "traceio.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLockFile>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+const char kMagic[] = "CANSESS1";
+const int kMagicSize = 8;
+const int kChunkHeaderSize = 8;
+const int kFlushFrames = 4096;                       // wake the writer early above this
+const std::chrono::milliseconds kFlushInterval(250);
+const qint64 kStatsIntervalMs = 5000;                // stats are rewritten at most this often
+const QDataStream::Version kStreamVersion = QDataStream::Qt_5_12;
+const int kImportChunkFrames = 16384;
+const char kIndexMagic[] = "CANSIDX1";
+const int kIndexEntrySize = 12;
+const int kIndexTrailerSize = 16;
+const int kIndexFixedSize = 36 + kIndexTrailerSize;
+
+} // namespace
+
+// -------------------- LIFETIME --------------------
+SessionStore::SessionStore()
+    : recentCount(0)
+    , syncRequested(0)
+    , syncDone(0)
+    , committedSize(0)
+    , settingsDirty(false)
+    , resetRequested(false)
+    , stopRequested(false)
+    , totalFrames(0)
+    , tailRecords(0)
+{
+}
+
+SessionStore::~SessionStore()
+{
+    if (!writer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopRequested = true;
+    }
+    wake.notify_one();
+    writer.join();
+}
+
+QString SessionStore::defaultPath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/last.cansession";
+}
+
+bool SessionStore::open(const QString &path, int recent, QString *error)
+{
+    if (writer.joinable())
+        return true;
+
+    // A second writer would interleave its chunks with ours. Locks left by a
+    // crashed run are recognized by their dead PID and taken over.
+    std::unique_ptr<QLockFile> lock(new QLockFile(path + ".lock"));
+    lock->setStaleLockTime(0);
+    if (!lock->tryLock()) {
+        if (error) {
+            qint64 pid = 0;
+            QString host, application;
+            *error = lock->getLockInfo(&pid, &host, &application)
+                ? QString("Session in use by another instance (pid %1)").arg(pid)
+                : QString("Session is locked: %1").arg(path + ".lock");
+        }
+        return false;
+    }
+
+    file.setFileName(path);
+    recentCount = recent;
+    if (!restore(error))
+        return false;
+
+    lockFile = std::move(lock);
+
+    writer = std::thread(&SessionStore::writerLoop, this);
+    return true;
+}
+
+// -------------------- RESTORE --------------------
+bool SessionStore::restore(QString *error)
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    if (!file.open(QFile::ReadWrite)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    const qint64 size = file.size();
+    qint64 validEnd = 0;
+
+    if (size >= kMagicSize) {
+        uchar *map = file.map(0, size);
+        if (!map) {
+            if (error)
+                *error = file.errorString();
+            file.close();
+            return false;
+        }
+
+        if (memcmp(map, kMagic, kMagicSize) == 0) {
+            if (readIndex(map, size, &validEnd)) {
+                // Clean shutdown: the index is dropped again, appending resumes before it
+                restoredSession.indexed = true;
+            } else {
+                // Crashed run: walk the chunk headers, frame payloads stay on disk
+                qint64 offset = kMagicSize;
+                validEnd = offset;
+                while (offset + kChunkHeaderSize <= size) {
+                    const quint32 type = qFromLittleEndian<quint32>(map + offset);
+                    const quint32 bytes = qFromLittleEndian<quint32>(map + offset + 4);
+                    const qint64 payload = offset + kChunkHeaderSize;
+                    if (payload + bytes > size)
+                        break;      // Cut short by a crash
+
+                    if (type == Frames) {
+                        noteFrameChunk(payload, bytes / CanRecord::kSize);
+                        restoredSession.totalFrames += bytes / CanRecord::kSize;
+                    } else if (type == Settings) {
+                        settingsChunk = {payload, bytes};
+                    } else if (type == Stats) {
+                        statsChunk = {payload, bytes};
+                    }
+
+                    offset = payload + bytes;
+                    validEnd = offset;
+                }
+            }
+
+            // The monitor only shows the tail of the session
+            QVector<CanMessage> &recent = restoredSession.recentFrames;
+            for (int c = tailChunks.size() - 1; c >= 0 && recent.size() < recentCount; c--) {
+                const uchar *records = map + tailChunks[c].offset;
+                for (qint64 i = qint64(tailChunks[c].size) - 1; i >= 0 && recent.size() < recentCount; i--)
+                    recent.append(CanRecord::read(records + i * CanRecord::kSize));
+            }
+            std::reverse(recent.begin(), recent.end());
+
+            if (settingsChunk.offset >= 0) {
+                QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(map + settingsChunk.offset), int(settingsChunk.size));
+                QDataStream in(bytes);
+                in.setVersion(kStreamVersion);
+                in >> restoredSession.settings;
+            }
+
+            if (statsChunk.offset >= 0) {
+                QByteArray bytes = QByteArray::fromRawData(reinterpret_cast<const char*>(map + statsChunk.offset), int(statsChunk.size));
+                QDataStream in(bytes);
+                in.setVersion(kStreamVersion);
+                quint32 count = 0;
+                in >> count;
+                for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+                    IdStatistics s;
+                    in >> s.id >> s.count >> s.firstNs >> s.lastNs >> s.minPeriodNs >> s.maxPeriodNs
+                       >> s.periodSumNs >> s.periods >> s.firstDlc >> s.lastDlc >> s.dlcChanges;
+                    s.matchesFilter = true;
+                    stats.insert(s.id, s);
+                }
+            }
+        }
+
+        file.unmap(map);
+    }
+
+    if (validEnd == 0) {
+        // Missing, empty or foreign file: start a fresh session
+        file.resize(0);
+        file.write(kMagic, kMagicSize);
+        validEnd = kMagicSize;
+    } else if (validEnd < size) {
+        file.resize(validEnd);
+    }
+    file.seek(validEnd);
+
+    settings = restoredSession.settings;
+    totalFrames = restoredSession.totalFrames;
+    committedSize = validEnd;
+    restoredSession.elapsedUs = elapsed.nsecsElapsed() / 1000;
+    return true;
+}
+
+// Index chunk payload, all little endian:
+//   u64 total frames
+//   u64 settings payload offset, u32 size     (offset 0: none)
+//   u64 stats payload offset, u32 size
+//   u32 N, then N x (u64 frame payload offset, u32 records), oldest first
+//   u64 offset of the index chunk itself, "CANSIDX1"
+// The trailer is the last 16 bytes of the file, so it is found with one read.
+bool SessionStore::readIndex(const uchar *map, qint64 size, qint64 *indexAt)
+{
+    if (size < kMagicSize + kChunkHeaderSize + kIndexFixedSize
+        || memcmp(map + size - kMagicSize, kIndexMagic, kMagicSize) != 0)
+        return false;
+
+    const quint64 at = qFromLittleEndian<quint64>(map + size - kIndexTrailerSize);
+    if (at < quint64(kMagicSize) || at > quint64(size - kChunkHeaderSize - kIndexFixedSize))
+        return false;
+    const qint64 payloadSize = size - qint64(at) - kChunkHeaderSize;
+    if (qFromLittleEndian<quint32>(map + at) != Index
+        || qFromLittleEndian<quint32>(map + at + 4) != quint32(payloadSize))
+        return false;
+
+    const uchar *in = map + at + kChunkHeaderSize;
+    const quint32 chunks = qFromLittleEndian<quint32>(in + 32);
+    if (payloadSize != kIndexFixedSize + qint64(chunks) * kIndexEntrySize)
+        return false;
+
+    // Everything referenced must lie before the index
+    auto valid = [at](quint64 offset, quint64 bytes) {
+        return offset >= quint64(kMagicSize + kChunkHeaderSize) && offset + bytes <= at;
+    };
+
+    ChunkRef settingsRef{qint64(qFromLittleEndian<quint64>(in + 8)), qFromLittleEndian<quint32>(in + 16)};
+    ChunkRef statsRef{qint64(qFromLittleEndian<quint64>(in + 20)), qFromLittleEndian<quint32>(in + 28)};
+    if ((settingsRef.offset && !valid(quint64(settingsRef.offset), settingsRef.size))
+        || (statsRef.offset && !valid(quint64(statsRef.offset), statsRef.size)))
+        return false;
+
+    QVector<ChunkRef> frameRefs;
+    frameRefs.reserve(int(chunks));
+    for (quint32 i = 0; i < chunks; i++) {
+        const uchar *entry = in + 36 + i * kIndexEntrySize;
+        ChunkRef ref{qint64(qFromLittleEndian<quint64>(entry)), qFromLittleEndian<quint32>(entry + 8)};
+        if (!valid(quint64(ref.offset), quint64(ref.size) * CanRecord::kSize))
+            return false;
+        frameRefs.append(ref);
+    }
+
+    restoredSession.totalFrames = qFromLittleEndian<quint64>(in);
+    settingsChunk = settingsRef.offset ? settingsRef : ChunkRef();
+    statsChunk = statsRef.offset ? statsRef : ChunkRef();
+    tailChunks.clear();
+    tailRecords = 0;
+    for (const ChunkRef &ref : frameRefs)
+        noteFrameChunk(ref.offset, ref.size);
+    *indexAt = qint64(at);
+    return true;
+}
+
+// Keeps just enough of the newest frame chunks to cover recentCount
+void SessionStore::noteFrameChunk(qint64 payloadOffset, quint32 records)
+{
+    tailChunks.append({payloadOffset, records});
+    tailRecords += records;
+    while (tailChunks.size() > 1 && tailRecords - tailChunks.first().size >= quint64(recentCount)) {
+        tailRecords -= tailChunks.first().size;
+        tailChunks.removeFirst();
+    }
+}
+
+// -------------------- PRODUCERS (GUI thread) --------------------
+void SessionStore::append(const QVector<CanMessage> &frames)
+{
+    if (!writer.joinable() || frames.isEmpty())
+        return;
+
+    bool flush;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending += frames;
+        flush = pending.size() >= kFlushFrames;
+    }
+    if (flush)
+        wake.notify_one();
+}
+
+void SessionStore::append(const CanMessage &frame)
+{
+    append(QVector<CanMessage>{frame});
+}
+
+void SessionStore::setSetting(const QString &key, const QVariant &value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (settings.value(key) == value)
+        return;
+    settings.insert(key, value);
+    settingsDirty = true;
+}
+
+void SessionStore::reset()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.clear();
+        stats.clear();
+        totalFrames = 0;
+        resetRequested = true;
+        settingsDirty = true;   // Rewritten into the new file
+    }
+    wake.notify_one();
+}
+
+quint64 SessionStore::frameCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return totalFrames + quint64(pending.size());
+}
+
+QVector<IdStatistics> SessionStore::statistics() const
+{
+    QVector<IdStatistics> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reserve(stats.size());
+        for (const IdStatistics &s : stats)
+            result.append(s);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const IdStatistics &a, const IdStatistics &b) { return a.id < b.id; });
+    return result;
+}
+
+// -------------------- EXPORT / IMPORT --------------------
+void SessionStore::sync()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!writer.joinable() || stopRequested)
+        return;
+
+    const quint64 target = ++syncRequested;
+    wake.notify_one();
+    committed.wait(lock, [this, target]() { return syncDone >= target || stopRequested; });
+}
+
+bool SessionStore::exportTo(const QString &path, QString *error, const std::atomic<bool> *cancel)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    const TraceFormat format = traceFormatForPath(path);
+    if (format == TraceFormat::Unknown)
+        return fail("Unsupported trace format");
+
+    sync();
+    qint64 size;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size = committedSize;
+    }
+
+    // Separate handle, the writer thread keeps appending behind size
+    QFile session(file.fileName());
+    if (!session.open(QFile::ReadOnly))
+        return fail(session.errorString());
+    size = qMin(size, session.size());
+
+    QFile output(path);
+    if (!output.open(QFile::WriteOnly | QFile::Truncate))
+        return fail(output.errorString());
+    TraceWriter writer(&output, format);
+
+    if (size > kMagicSize) {
+        const uchar *map = session.map(0, size);
+        if (!map)
+            return fail(session.errorString());
+
+        for (qint64 offset = kMagicSize; offset + kChunkHeaderSize <= size;) {
+            const quint32 type = qFromLittleEndian<quint32>(map + offset);
+            const quint32 bytes = qFromLittleEndian<quint32>(map + offset + 4);
+            const qint64 payload = offset + kChunkHeaderSize;
+            if (payload + bytes > size)
+                break;
+            if (cancel && *cancel)
+                return fail("Cancelled");
+
+            if (type == Frames) {
+                for (quint32 i = 0; i + CanRecord::kSize <= bytes; i += CanRecord::kSize) {
+                    CanMessage msg = CanRecord::read(map + payload + i);
+                    msg.timestampNs = CaptureClock::toEpochNs(msg.timestampNs);
+                    if (!writer.write(msg))
+                        return fail(output.errorString());
+                }
+            }
+            offset = payload + bytes;
+        }
+    }
+
+    if (!writer.finish())
+        return fail(output.errorString());
+    return true;
+}
+
+bool SessionStore::importFrom(const QString &path, QVector<CanMessage> *recent, QString *error,
+                              const std::atomic<bool> *cancel)
+{
+    const TraceFormat format = traceFormatForPath(path);
+    QFile input(path);
+    if (format == TraceFormat::Unknown || !input.open(QFile::ReadOnly)) {
+        if (error)
+            *error = format == TraceFormat::Unknown ? "Unsupported trace format" : input.errorString();
+        return false;
+    }
+
+    reset();
+
+    // Newest frames for the monitor, kept in a ring while streaming
+    QVector<CanMessage> tail;
+    tail.reserve(recentCount);
+    int tailHead = 0;
+
+    TraceReader reader(&input, format);
+    QVector<CanMessage> chunk;
+    while (reader.readChunk(chunk, kImportChunkFrames)) {
+        if (cancel && *cancel) {
+            if (error)
+                *error = "Cancelled";
+            return false;
+        }
+        for (CanMessage &msg : chunk) {
+            msg.timestampNs = CaptureClock::fromEpochNs(msg.timestampNs);
+            if (tail.size() < recentCount) {
+                tail.append(msg);
+            } else if (recentCount > 0) {
+                tail[tailHead] = msg;
+                tailHead = (tailHead + 1) % recentCount;
+            }
+        }
+        append(chunk);
+        sync();     // Bounds memory to one chunk whatever the trace size
+    }
+
+    if (recent) {
+        recent->clear();
+        for (int i = 0; i < tail.size(); i++)
+            recent->append(tail[(tailHead + i) % tail.size()]);
+    }
+    return true;
+}
+
+// -------------------- WRITER THREAD --------------------
+void SessionStore::writerLoop()
+{
+    QElapsedTimer sinceStats;
+    sinceStats.start();
+    bool statsDirty = false;
+
+    for (;;) {
+        QVector<CanMessage> frames;
+        QByteArray settingsBlob;
+        QByteArray statsBlob;
+        bool rotate;
+        bool stopping;
+        quint64 syncTarget;
+        quint64 framesSoFar;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, kFlushInterval, [this]() {
+                return stopRequested || resetRequested || syncRequested != syncDone
+                    || pending.size() >= kFlushFrames;
+            });
+
+            syncTarget = syncRequested;
+            frames.swap(pending);
+            stopping = stopRequested;
+
+            // On reset() or past the cap the file moves to <path>.1 and a new
+            // session starts; statistics and the frame count restart with it
+            rotate = resetRequested || committedSize + qint64(frames.size()) * CanRecord::kSize > kMaxFileBytes;
+            resetRequested = false;
+            if (rotate) {
+                stats.clear();
+                totalFrames = 0;
+                settingsDirty = true;
+            }
+
+            // Statistics follow the frames they were computed from
+            updateStatistics(frames);
+            totalFrames += quint64(frames.size());
+            statsDirty = (statsDirty && !rotate) || !frames.isEmpty();
+            framesSoFar = totalFrames;
+
+            if (settingsDirty) {
+                QDataStream out(&settingsBlob, QIODevice::WriteOnly);
+                out.setVersion(kStreamVersion);
+                out << settings;
+                settingsDirty = false;
+            }
+
+            if (statsDirty && (stopping || sinceStats.elapsed() >= kStatsIntervalMs)) {
+                statsBlob = encodeStatistics();
+                statsDirty = false;
+                sinceStats.restart();
+            }
+        }
+
+        if (rotate) {
+            const QString path = file.fileName();
+            file.close();
+            QFile::remove(path + ".1");
+            QFile::rename(path, path + ".1");
+            file.setFileName(path);
+            file.open(QFile::ReadWrite | QFile::Truncate);
+            file.write(kMagic, kMagicSize);
+            settingsChunk = ChunkRef();
+            statsChunk = ChunkRef();
+            tailChunks.clear();
+            tailRecords = 0;
+        }
+
+        if (!frames.isEmpty()) {
+            QByteArray payload(frames.size() * CanRecord::kSize, Qt::Uninitialized);
+            uchar *out = reinterpret_cast<uchar*>(payload.data());
+            for (const CanMessage &msg : frames) {
+                CanRecord::write(out, msg);
+                out += CanRecord::kSize;
+            }
+            noteFrameChunk(writeChunk(Frames, payload), quint32(frames.size()));
+        }
+        if (!settingsBlob.isEmpty())
+            settingsChunk = {writeChunk(Settings, settingsBlob), quint32(settingsBlob.size())};
+        if (!statsBlob.isEmpty())
+            statsChunk = {writeChunk(Stats, statsBlob), quint32(statsBlob.size())};
+
+        if (stopping)
+            writeIndex(framesSoFar);
+
+        if (rotate || stopping || !frames.isEmpty() || !settingsBlob.isEmpty() || !statsBlob.isEmpty())
+            file.flush();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            syncDone = syncTarget;
+            committedSize = file.pos();
+        }
+        committed.notify_all();
+
+        if (stopping)
+            break;
+    }
+
+    file.close();
+}
+
+// Returns the file offset of the payload
+qint64 SessionStore::writeChunk(ChunkType type, const QByteArray &payload)
+{
+    uchar header[kChunkHeaderSize];
+    qToLittleEndian<quint32>(type, header);
+    qToLittleEndian<quint32>(quint32(payload.size()), header + 4);
+    file.write(reinterpret_cast<const char*>(header), kChunkHeaderSize);
+    const qint64 offset = file.pos();
+    file.write(payload);
+    return offset;
+}
+
+// Layout in readIndex(). Written last on a clean shutdown.
+void SessionStore::writeIndex(quint64 frames)
+{
+    QByteArray payload(kIndexFixedSize + tailChunks.size() * kIndexEntrySize, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar*>(payload.data());
+    qToLittleEndian<quint64>(frames, out);
+    qToLittleEndian<quint64>(quint64(qMax<qint64>(settingsChunk.offset, 0)), out + 8);
+    qToLittleEndian<quint32>(settingsChunk.size, out + 16);
+    qToLittleEndian<quint64>(quint64(qMax<qint64>(statsChunk.offset, 0)), out + 20);
+    qToLittleEndian<quint32>(statsChunk.size, out + 28);
+    qToLittleEndian<quint32>(quint32(tailChunks.size()), out + 32);
+    out += 36;
+    for (const ChunkRef &ref : std::as_const(tailChunks)) {
+        qToLittleEndian<quint64>(quint64(ref.offset), out);
+        qToLittleEndian<quint32>(ref.size, out + 8);
+        out += kIndexEntrySize;
+    }
+    qToLittleEndian<quint64>(quint64(file.pos()), out);
+    memcpy(out + 8, kIndexMagic, kMagicSize);
+    writeChunk(Index, payload);
+}
+
+// Called with the mutex held
+void SessionStore::updateStatistics(const QVector<CanMessage> &frames)
+{
+    for (const CanMessage &msg : frames) {
+        // Same accumulator as CaptureAnalyzer, so both report the same numbers
+        IdStatistics &s = stats[msg.id];
+        s.id = msg.id;
+        s.matchesFilter = true;
+        s.add(CaptureClock::toEpochNs(msg.timestampNs), msg.dlc);
+    }
+}
+
+// Called with the mutex held
+QByteArray SessionStore::encodeStatistics() const
+{
+    QByteArray blob;
+    QDataStream out(&blob, QIODevice::WriteOnly);
+    out.setVersion(kStreamVersion);
+    out << quint32(stats.size());
+    for (const IdStatistics &s : stats) {
+        out << s.id << s.count << s.firstNs << s.lastNs << s.minPeriodNs << s.maxPeriodNs
+            << s.periodSumNs << s.periods << s.firstDlc << s.lastDlc << s.dlcChanges;
+    }
+    return blob;
+}
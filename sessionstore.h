@@ -0,0 +1,137 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include "canmessage.h"
+#include "captureanalyzer.h"
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class QLockFile;
+
+// Persistent capture session: every frame plus the state needed to pick up
+// where the previous run stopped (connection, filters, transmit schedule).
+//
+// The file is an 8-byte magic followed by an append-only list of chunks,
+// each an u32 type and u32 payload size (little endian):
+//   Frames    N fixed 24-byte records (canrecord.h)
+//   Settings  QDataStream'ed QVariantMap, the last one wins
+//   Stats     per-ID statistics, the last one wins
+//
+//   Index     written last on a clean shutdown (see readIndex)
+//
+// Frames are handed over in O(1) and written by a background thread, so
+// saving never stalls ingest. On launch the file is memory mapped. After a
+// clean shutdown the trailing index points straight at the latest settings,
+// stats and the frame chunks holding the monitor's tail, so restore reads a
+// fixed amount whatever the session length. After a crash the chunk headers
+// are walked instead (one per flush, frame payloads are not touched) and a
+// chunk cut short is dropped. Export walks the chunks and streams every
+// record, so it covers the full history.
+//
+// Past kMaxFileBytes, and on reset(), the file is renamed to <path>.1,
+// replacing an older one, and a new session starts with the current
+// settings. Nothing recorded is ever truncated in place.
+//
+// One writer per file: open() holds <path>.lock for the store's lifetime
+// and fails while another instance has it.
+class SessionStore
+{
+public:
+    struct Restored {
+        QVector<CanMessage> recentFrames;   // Oldest first, capture clock
+        quint64 totalFrames = 0;
+        QVariantMap settings;
+        qint64 elapsedUs = 0;
+        bool indexed = false;               // Restored from the index
+    };
+
+    static const qint64 kMaxFileBytes = 512LL * 1024 * 1024;
+
+    SessionStore();
+    ~SessionStore();    // Flushes pending frames
+
+    static QString defaultPath();
+
+    // Restores the session at path (if any) and keeps appending to it.
+    // Fails if another process has the session open.
+    bool open(const QString &path, int recentCount, QString *error = nullptr);
+    bool isOpen() const { return writer.joinable(); }
+    const Restored &restored() const { return restoredSession; }
+
+    void append(const QVector<CanMessage> &frames);
+    void append(const CanMessage &frame);
+    void setSetting(const QString &key, const QVariant &value);
+    void reset();       // Start over with an empty session, the old one moves to <path>.1
+
+    // Blocks until every frame appended so far is written. Any thread.
+    void sync();
+
+    // Streams the whole recorded history to a trace file. Any thread.
+    // Both transfers stop early, failing with "Cancelled", once *cancel is set.
+    bool exportTo(const QString &path, QString *error = nullptr, const std::atomic<bool> *cancel = nullptr);
+
+    // Replaces the history with the frames of a trace file (reset() first)
+    // and returns the newest recentCount of them (oldest first, capture
+    // clock). Any thread; the caller keeps live frames out meanwhile.
+    bool importFrom(const QString &path, QVector<CanMessage> *recent, QString *error = nullptr,
+                    const std::atomic<bool> *cancel = nullptr);
+
+    quint64 frameCount() const;
+    QVector<IdStatistics> statistics() const;   // Sorted by ID, epoch ns
+
+private:
+    enum ChunkType : quint32 { Frames = 1, Settings = 2, Stats = 3, Index = 4 };
+
+    struct ChunkRef {
+        qint64 offset = -1;     // Payload offset in the file
+        quint32 size = 0;       // Bytes, records for frame chunks
+    };
+
+    bool restore(QString *error);
+    bool readIndex(const uchar *map, qint64 size, qint64 *indexAt);
+    void noteFrameChunk(qint64 payloadOffset, quint32 records);
+    void writerLoop();
+    qint64 writeChunk(ChunkType type, const QByteArray &payload);
+    void writeIndex(quint64 frames);
+    void updateStatistics(const QVector<CanMessage> &frames);
+    QByteArray encodeStatistics() const;
+
+    std::unique_ptr<QLockFile> lockFile;    // Held while open
+    QFile file;
+    Restored restoredSession;
+    int recentCount;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable committed;      // Signalled after each write pass
+    quint64 syncRequested;
+    quint64 syncDone;
+    qint64 committedSize;                   // File bytes covered by syncDone
+    QVector<CanMessage> pending;
+    QVariantMap settings;
+    bool settingsDirty;
+    bool resetRequested;
+    bool stopRequested;
+    QHash<quint32, IdStatistics> stats;
+    quint64 totalFrames;
+
+    // Latest chunks, owned by restore() and then the writer thread
+    ChunkRef settingsChunk;
+    ChunkRef statsChunk;
+    QVector<ChunkRef> tailChunks;
+    quint64 tailRecords;
+
+    std::thread writer;
+};
+
+#endif // SESSIONSTORE_H
@@ -0,0 +1,274 @@
+#include "socketcantransport.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSocketNotifier>
+#include <QStringList>
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const int kBatchSize = 64;
+const int kArphrdCan = 280; // ARPHRD_CAN in <linux/if_arp.h>
+const qint64 kMaxStampAgeNs = 2000000000; // frames wait in the socket while the GUI thread is busy
+
+quint64 toNs(const timespec &ts)
+{
+    return quint64(ts.tv_sec) * 1000000000ULL + quint64(ts.tv_nsec);
+}
+
+} // namespace
+
+// Preallocated recvmmsg() buffers, reused for every batch
+struct SocketCanTransport::RxBatch {
+    can_frame frames[kBatchSize];
+    iovec iov[kBatchSize];
+    mmsghdr msgs[kBatchSize];
+    char control[kBatchSize][CMSG_SPACE(3 * sizeof(timespec))];
+};
+
+SocketCanTransport::SocketCanTransport(QObject *parent)
+    : CanTransport(parent)
+    , fd(-1)
+    , notifier(nullptr)
+    , rx(new RxBatch)
+{
+}
+
+SocketCanTransport::~SocketCanTransport()
+{
+    close();
+    delete rx;
+}
+
+// -------------------- INTERFACES --------------------
+bool SocketCanTransport::isCanInterface(const QString &name)
+{
+    QFile typeFile("/sys/class/net/" + name + "/type");
+    if (!typeFile.open(QFile::ReadOnly))
+        return false;
+    return typeFile.readAll().trimmed().toInt() == kArphrdCan;
+}
+
+QStringList SocketCanTransport::availableInterfaces()
+{
+    QStringList interfaces;
+    const QStringList names = QDir("/sys/class/net").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : names) {
+        if (isCanInterface(name))
+            interfaces.append(name);
+    }
+    return interfaces;
+}
+
+// -------------------- OPEN / CLOSE --------------------
+bool SocketCanTransport::fail(const QString &what)
+{
+    lastError = what + ": " + QString::fromLocal8Bit(strerror(errno));
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    return false;
+}
+
+bool SocketCanTransport::open(const QString &name)
+{
+    close();
+    interfaceName = name;
+
+    fd = ::socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+    if (fd < 0)
+        return fail("socket");
+
+    ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, name.toLocal8Bit().constData(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+        return fail(name);
+
+    sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+        return fail("bind");
+
+    // Hardware timestamps when the controller supports them, software otherwise
+    int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE
+              | SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+    if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) {
+        int enable = 1;
+        setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    }
+
+    int rcvbuf = 4 * 1024 * 1024; // Absorb bursts while the GUI thread is busy
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    for (int i = 0; i < kBatchSize; i++) {
+        rx->iov[i].iov_base = &rx->frames[i];
+        rx->iov[i].iov_len = sizeof(can_frame);
+    }
+
+    notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &SocketCanTransport::readFrames);
+
+    hardwareClock.reset();
+    lastError.clear();
+    emit statusChanged();
+    return true;
+}
+
+void SocketCanTransport::close()
+{
+    if (fd < 0)
+        return;
+
+    // May run from the notifier's own activated() signal
+    notifier->setEnabled(false);
+    notifier->deleteLater();
+    notifier = nullptr;
+    ::close(fd);
+    fd = -1;
+    emit statusChanged();
+}
+
+// -------------------- RECEIVE --------------------
+void SocketCanTransport::readFrames()
+{
+    for (;;) {
+        for (int i = 0; i < kBatchSize; i++) {
+            msghdr &hdr = rx->msgs[i].msg_hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.msg_iov = &rx->iov[i];
+            hdr.msg_iovlen = 1;
+            hdr.msg_control = rx->control[i];
+            hdr.msg_controllen = sizeof(rx->control[i]);
+        }
+
+        int count = recvmmsg(fd, rx->msgs, kBatchSize, MSG_DONTWAIT, nullptr);
+        if (count <= 0) {
+            if (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                // Interface went down or was removed
+                lastError = "recvmmsg: " + QString::fromLocal8Bit(strerror(errno));
+                close();
+            }
+            return;
+        }
+
+        // Software stamps are CLOCK_REALTIME. The offset to the capture clock
+        // is sampled per batch rather than once at startup, so an NTP step
+        // does not shift every later frame.
+        timespec realtime;
+        clock_gettime(CLOCK_REALTIME, &realtime);
+        const quint64 arrivalNs = CaptureClock::nowNs();
+        const qint64 realtimeOffsetNs = qint64(toNs(realtime)) - qint64(arrivalNs);
+
+        QVector<CanMessage> frames;
+        frames.reserve(count);
+        for (int i = 0; i < count; i++) {
+            const can_frame &frame = rx->frames[i];
+            if (frame.can_id & CAN_ERR_FLAG)
+                continue;
+
+            CanMessage msg;
+            msg.extended = (frame.can_id & CAN_EFF_FLAG) != 0;
+            msg.rtr = (frame.can_id & CAN_RTR_FLAG) != 0;
+            msg.id = frame.can_id & (msg.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+            msg.dlc = quint8(qMin<int>(frame.can_dlc, 8));
+            memcpy(msg.data, frame.data, msg.dlc);
+
+            // Software stamp (index 0) is wall clock, raw hardware stamp (index 2)
+            // is in the controller's time base
+            quint64 softwareNs = 0;
+            quint64 hardwareNs = 0;
+            msghdr &hdr = rx->msgs[i].msg_hdr;
+            for (cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET)
+                    continue;
+                if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+                    timespec ts[3];
+                    memcpy(ts, CMSG_DATA(cmsg), sizeof(ts));
+                    softwareNs = toNs(ts[0]);
+                    hardwareNs = toNs(ts[2]);
+                } else if (cmsg->cmsg_type == SO_TIMESTAMPNS) {
+                    timespec ts;
+                    memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                    softwareNs = toNs(ts);
+                }
+            }
+
+            // A stamp after the read, or older than any backlog, means the wall
+            // clock stepped in between: the arrival time is the better guess
+            quint64 hostNs = arrivalNs;
+            if (softwareNs) {
+                const qint64 stampNs = qint64(softwareNs) - realtimeOffsetNs;
+                if (stampNs <= qint64(arrivalNs) && qint64(arrivalNs) - stampNs <= kMaxStampAgeNs)
+                    hostNs = quint64(stampNs);
+            }
+            msg.timestampNs = hardwareNs ? hardwareClock.map(hardwareNs, hostNs) : hostNs;
+            frames.append(msg);
+        }
+
+        if (!frames.isEmpty())
+            emit framesReceived(frames);
+
+        if (count < kBatchSize)
+            return;
+    }
+}
+
+// -------------------- TRANSMIT --------------------
+bool SocketCanTransport::writeFrames(const CanMessage *frames, int count)
+{
+    if (fd < 0)
+        return false;
+
+    can_frame txFrames[kBatchSize];
+    iovec iov[kBatchSize];
+    mmsghdr msgs[kBatchSize];
+
+    for (int offset = 0; offset < count; offset += kBatchSize) {
+        const int batch = qMin(kBatchSize, count - offset);
+        memset(msgs, 0, sizeof(mmsghdr) * size_t(batch));
+
+        for (int i = 0; i < batch; i++) {
+            const CanMessage &msg = frames[offset + i];
+            memset(&txFrames[i], 0, sizeof(can_frame));
+            txFrames[i].can_id = msg.extended ? (msg.id | CAN_EFF_FLAG) : msg.id;
+            if (msg.rtr)
+                txFrames[i].can_id |= CAN_RTR_FLAG;
+            txFrames[i].can_dlc = msg.dlc;
+            memcpy(txFrames[i].data, msg.data, msg.dlc);
+
+            iov[i].iov_base = &txFrames[i];
+            iov[i].iov_len = sizeof(can_frame);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int sent = 0;
+        while (sent < batch) {
+            int n = sendmmsg(fd, msgs + sent, unsigned(batch - sent), 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                lastError = "sendmmsg: " + QString::fromLocal8Bit(strerror(errno));
+                return false;
+            }
+            sent += n;
+        }
+    }
+    return true;
+}
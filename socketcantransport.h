@@ -0,0 +1,59 @@
+#ifndef SOCKETCANTRANSPORT_H
+#define SOCKETCANTRANSPORT_H
+
+#include "cantransport.h"
+#include "captureclock.h"
+
+#include <QStringList>
+
+class QSocketNotifier;
+
+// Native Linux SocketCAN transport (can0, vcan0, ...).
+//
+// Frames are received and sent in batches with recvmmsg()/sendmmsg() and
+// stamped by the kernel. Software timestamps (wall clock) are moved onto the
+// capture clock with an offset sampled per batch, and checked against the
+// arrival time so a wall-clock step cannot misplace them; hardware timestamps
+// come from the controller's own clock and are mapped onto it with a
+// DeviceClockSync.
+//
+// Can be exercised without hardware on a virtual interface:
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+class SocketCanTransport : public CanTransport
+{
+    Q_OBJECT
+
+public:
+    explicit SocketCanTransport(QObject *parent = nullptr);
+    ~SocketCanTransport();
+
+    bool open(const QString &interfaceName);
+    void close();
+
+    bool isOpen() const override { return fd >= 0; }
+    QString name() const override { return interfaceName; }
+    QString errorString() const override { return lastError; }
+
+    bool writeFrames(const CanMessage *frames, int count) override;
+
+    // True if the name is a CAN network interface (ARPHRD_CAN)
+    static bool isCanInterface(const QString &name);
+    static QStringList availableInterfaces();
+
+private slots:
+    void readFrames();
+
+private:
+    bool fail(const QString &what);
+
+    struct RxBatch;
+
+    int fd;
+    QString interfaceName;
+    QString lastError;
+    QSocketNotifier *notifier;
+    RxBatch *rx;
+    DeviceClockSync hardwareClock;
+};
+
+#endif // SOCKETCANTRANSPORT_H
@@ -0,0 +1,298 @@
+// Golden vectors and a throughput floor for the UART bridge protocol
+// (bridgeprotocol.h). Plain executable registered with CTest; a non-zero
+// exit code is a failure.
+
+#include "bridgeprotocol.h"
+
+#include <QByteArray>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+// Decoder output, in stream order
+struct Event {
+    bool error;
+    CanMessage msg;
+    quint64 deviceUs;
+};
+
+std::vector<Event> drain(BridgeLineDecoder &decoder)
+{
+    std::vector<Event> events;
+    CanMessage msg;
+    quint64 deviceUs = 0;
+    BridgeLineDecoder::Status status;
+    while (decoder.next(&msg, &deviceUs, &status))
+        events.push_back({status == BridgeLineDecoder::Status::Error, msg, deviceUs});
+    return events;
+}
+
+std::vector<Event> decode(const std::string &input, int chunkSize = 0)
+{
+    BridgeLineDecoder decoder;
+    std::vector<Event> events;
+    const int size = int(input.size());
+    const int step = chunkSize > 0 ? chunkSize : qMax(size, 1);
+    for (int offset = 0; offset < size; offset += step) {
+        decoder.append(input.data() + offset, qMin(step, size - offset));
+        for (const Event &event : drain(decoder))
+            events.push_back(event);
+    }
+    return events;
+}
+
+bool isFrame(const std::vector<Event> &events, size_t index, quint32 id, const std::vector<quint8> &data)
+{
+    if (index >= events.size() || events[index].error)
+        return false;
+    const CanMessage &msg = events[index].msg;
+    return msg.id == id && msg.dlc == data.size()
+        && (data.empty() || memcmp(msg.data, data.data(), data.size()) == 0);
+}
+
+bool parses(const std::string &line)
+{
+    CanMessage msg;
+    quint64 deviceUs;
+    return BridgeProtocol::parseLine(line.data(), line.data() + line.size(), &msg, &deviceUs);
+}
+
+// -------------------- GOLDEN VECTORS --------------------
+void testSplitReads()
+{
+    const std::string input = "[ID 0x1900140] 11 22 33 44 55 66 77 88 t=123456\n[ID 0x7DF] 02 01 0D\n";
+    for (int chunk : {1, 2, 3, 7, 16, 64}) {
+        const std::vector<Event> events = decode(input, chunk);
+        CHECK(events.size() == 2);
+        CHECK(isFrame(events, 0, 0x1900140, {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88}));
+        CHECK(events.size() > 0 && events[0].deviceUs == 123456);
+        CHECK(isFrame(events, 1, 0x7DF, {0x02, 0x01, 0x0D}));
+    }
+
+    // No terminator yet: nothing decoded, bytes kept
+    BridgeLineDecoder decoder;
+    decoder.append("[ID 0x123] 11", 13);
+    CHECK(drain(decoder).empty());
+    CHECK(decoder.pendingBytes() == 13);
+    decoder.append(" 22\n", 4);
+    const std::vector<Event> events = drain(decoder);
+    CHECK(events.size() == 1 && isFrame(events, 0, 0x123, {0x11, 0x22}));
+}
+
+void testTerminators()
+{
+    // "\n", "\r\n" and a bare "\r" each end exactly one line
+    const std::vector<Event> events = decode("[ID 0x1] 01\n[ID 0x2] 02\r\n[ID 0x3] 03\r[ID 0x4] 04\n");
+    CHECK(events.size() == 4);
+    CHECK(isFrame(events, 0, 0x1, {0x01}));
+    CHECK(isFrame(events, 1, 0x2, {0x02}));
+    CHECK(isFrame(events, 2, 0x3, {0x03}));
+    CHECK(isFrame(events, 3, 0x4, {0x04}));
+
+    // "\r" and "\n" split across reads, blank lines ignored
+    const std::vector<Event> split = decode("[ID 0x5] 05\r\n\r\n  \n[ID 0x6] 06\r", 12);
+    CHECK(split.size() == 2);
+    CHECK(isFrame(split, 0, 0x5, {0x05}));
+    CHECK(isFrame(split, 1, 0x6, {0x06}));
+}
+
+void testPayloadLength()
+{
+    // DLC is the number of bytes, 0-8
+    std::vector<Event> events = decode("[ID 0x123]\n[ID 0x123] AA BB CC\n[ID 0x123] 0102030405060708\n");
+    CHECK(events.size() == 3);
+    CHECK(isFrame(events, 0, 0x123, {}));
+    CHECK(isFrame(events, 1, 0x123, {0xAA, 0xBB, 0xCC}));
+    CHECK(isFrame(events, 2, 0x123, {1, 2, 3, 4, 5, 6, 7, 8}));
+
+    // More than 8 bytes
+    CHECK(!parses("[ID 0x123] 11 22 33 44 55 66 77 88 99"));
+    events = decode("[ID 0x123] 11 22 33 44 55 66 77 88 99\n");
+    CHECK(events.size() == 1 && events[0].error);
+}
+
+void testHexDigits()
+{
+    CHECK(!parses("[ID 0x123] 1"));
+    CHECK(!parses("[ID 0x123] 112"));
+    CHECK(!parses("[ID 0x123] 11 2 33"));
+    CHECK(!parses("[ID 0x123] 1G"));
+    CHECK(!parses("[ID 0x] 11"));
+    CHECK(!parses("[ID 0x12G] 11"));
+    CHECK(parses("[ID 0xabc] ff Ee"));
+}
+
+void testIdRange()
+{
+    CanMessage msg;
+    quint64 deviceUs;
+    const std::string maxId = "[ID 0x1FFFFFFF] 00";
+    CHECK(BridgeProtocol::parseLine(maxId.data(), maxId.data() + maxId.size(), &msg, &deviceUs));
+    CHECK(msg.id == 0x1FFFFFFF && msg.extended);
+
+    const std::string standard = "[ID 0x7FF] 00";
+    CHECK(BridgeProtocol::parseLine(standard.data(), standard.data() + standard.size(), &msg, &deviceUs));
+    CHECK(msg.id == 0x7FF && !msg.extended);
+
+    CHECK(!parses("[ID 0x20000000] 00"));      // Above 29 bits
+    CHECK(!parses("[ID 0xFFFFFFFF] 00"));
+    CHECK(!parses("[ID 0x100000000] 00"));     // 9 digits
+}
+
+void testTimestamp()
+{
+    CanMessage msg;
+    quint64 deviceUs = 1;
+    const std::string none = "[ID 0x123] 11";
+    CHECK(BridgeProtocol::parseLine(none.data(), none.data() + none.size(), &msg, &deviceUs));
+    CHECK(deviceUs == 0);
+
+    const std::string stamped = "[ID 0x123] 11 t=18446744073709551615";
+    CHECK(BridgeProtocol::parseLine(stamped.data(), stamped.data() + stamped.size(), &msg, &deviceUs));
+    CHECK(deviceUs == 18446744073709551615ULL);
+
+    CHECK(!parses("[ID 0x123] 11 t="));
+    CHECK(!parses("[ID 0x123] 11 t=12a"));
+    CHECK(!parses("[ID 0x123] 11 t=12 22"));          // Must be last
+    CHECK(!parses("[ID 0x123] 11 t 12"));
+    CHECK(!parses("[ID 0x123] 11 t=18446744073709551616"));  // Overflow
+}
+
+void testOverlongLineResync()
+{
+    // A lost newline: reported once, then the decoder resynchronizes on
+    // the next terminator without buffering the junk
+    std::string junk(BridgeProtocol::kMaxLineLength + 100, '7');
+    BridgeLineDecoder decoder;
+    decoder.append(junk.data(), int(junk.size()));
+    std::vector<Event> events = drain(decoder);
+    CHECK(events.size() == 1 && events[0].error);
+    CHECK(decoder.pendingBytes() == 0);
+
+    decoder.append(junk.data(), int(junk.size()));
+    CHECK(drain(decoder).empty());                     // Same line, not reported again
+
+    const std::string tail = "77\n[ID 0x321] 01 02\n";
+    decoder.append(tail.data(), int(tail.size()));
+    events = drain(decoder);
+    CHECK(events.size() == 1 && isFrame(events, 0, 0x321, {0x01, 0x02}));
+
+    // An overlong line that does end is an error too
+    events = decode(std::string(BridgeProtocol::kMaxLineLength + 1, ' ') + "[ID 0x1] 01\n[ID 0x2] 02\n");
+    CHECK(events.size() == 2 && events[0].error && isFrame(events, 1, 0x2, {0x02}));
+}
+
+void testGarbage()
+{
+    const std::vector<Event> events = decode("hello\n[ID 0x1]x\n[id 0x1] 01\n[ID 0x10] 10\n");
+    CHECK(events.size() == 4);
+    CHECK(events.size() == 4 && events[0].error && events[1].error && events[2].error);
+    CHECK(isFrame(events, 3, 0x10, {0x10}));
+}
+
+void testEncodeFrame()
+{
+    CanMessage msg;
+    msg.id = 0x1900140;
+    msg.dlc = 2;
+    msg.data[0] = 0x11;
+    msg.data[1] = 0x22;
+    char out[BridgeProtocol::kMaxTxRecordSize];
+    const int length = BridgeProtocol::encodeFrame(msg, out);
+    const unsigned char expected[] = {0xA5, 0x01, 0x90, 0x01, 0x40, 0x02, 0x11, 0x22};
+    CHECK(length == int(sizeof(expected)));
+    CHECK(memcmp(out, expected, sizeof(expected)) == 0);
+
+    msg.dlc = 8;
+    CHECK(BridgeProtocol::encodeFrame(msg, out) == BridgeProtocol::kMaxTxRecordSize);
+}
+
+void testEncodeRequest()
+{
+    // The legacy request every firmware understands: the bare ID
+    char out[BridgeProtocol::kRequestSize];
+    BridgeProtocol::encodeRequest(0x1900140, out);
+    const unsigned char expected[] = {0x01, 0x90, 0x01, 0x40};
+    CHECK(memcmp(out, expected, sizeof(expected)) == 0);
+
+    // Never mistaken for a framed record
+    BridgeProtocol::encodeRequest(BridgeProtocol::kMaxId, out);
+    CHECK(quint8(out[0]) != BridgeProtocol::kTxSync);
+}
+
+// -------------------- THROUGHPUT --------------------
+// Far above any UART rate (1 Mbit/s is ~2.5k lines/s). Recorded when the
+// floor was set: ~5M lines/s at -O2, ~1.5M at -O0 and ~2.6M with ASan/UBSan.
+// The floor leaves room for slow CI machines while still catching a
+// per-line allocation or an accidentally quadratic buffer.
+const double kMinLinesPerSecond = 200000;
+
+void testThroughput()
+{
+    std::string input;
+    const int lines = 200000;
+    for (int i = 0; i < lines; i++) {
+        char line[64];
+        snprintf(line, sizeof(line), "[ID 0x%07X] 11 22 33 44 55 66 77 88 t=%d\r\n", 0x1900000 + (i & 0xFF), i);
+        input += line;
+    }
+
+    BridgeLineDecoder decoder;
+    CanMessage msg;
+    quint64 deviceUs;
+    BridgeLineDecoder::Status status;
+    int frames = 0;
+
+    // Serial reads deliver a few KiB at a time
+    const int chunk = 4096;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < input.size(); offset += chunk) {
+        decoder.append(input.data() + offset, int(qMin<size_t>(chunk, input.size() - offset)));
+        while (decoder.next(&msg, &deviceUs, &status))
+            frames += status == BridgeLineDecoder::Status::Frame;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rate = lines / qMax(seconds, 1e-9);
+
+    printf("throughput: %.0f lines/s (floor %.0f)\n", rate, kMinLinesPerSecond);
+    CHECK(frames == lines);
+    CHECK(rate >= kMinLinesPerSecond);
+}
+
+} // namespace
+
+int main()
+{
+    testSplitReads();
+    testTerminators();
+    testPayloadLength();
+    testHexDigits();
+    testIdRange();
+    testTimestamp();
+    testOverlongLineResync();
+    testGarbage();
+    testEncodeFrame();
+    testEncodeRequest();
+    testThroughput();
+
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+// Paint time of a full screen of CAN monitor rows (frametablemodel.h,
+// payloaddelegate.h): the payload column must stay well under a
+// millisecond; the whole table view is printed for reference. Also checks
+// that remote frames carry their DLC instead of payload bytes.
+// Plain executable registered with CTest, runs on the offscreen platform;
+// a non-zero exit code is a failure.
+
+#include "capturepipeline.h"
+#include "framefilter.h"
+#include "frametablemodel.h"
+#include "payloaddelegate.h"
+
+#include <QApplication>
+#include <QHeaderView>
+#include <QImage>
+#include <QPainter>
+#include <QTableView>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+const int kScreenWidth = 1920;
+const int kScreenHeight = 1080;
+const int kRowHeight = 32;              // The monitor's fixed row height
+const int kPayloadColumnWidth = 900;    // Stretched data column at 1920 px
+const int kRuns = 200;
+const double kMaxPayloadPaintMs = 1.0;
+
+// A full store of traffic over a few IDs with changing bytes, one remote frame
+QVector<CanMessage> busyFrames()
+{
+    QVector<CanMessage> frames;
+    for (int i = 0; i < CapturePipeline::kMaxFrames; i++) {
+        CanMessage msg;
+        msg.timestampNs = 1000000000ULL + quint64(i) * 1000000ULL;
+        msg.id = 0x1900140 + quint32(i % 6);
+        msg.extended = true;
+        msg.tx = i % 4 == 0;
+        msg.dlc = 8;
+        for (int b = 0; b < 8; b++)
+            msg.data[b] = quint8((i / 6) * (b + 1) + b);
+        frames.append(msg);
+    }
+    CanMessage remote;
+    remote.timestampNs = frames.last().timestampNs + 1000000ULL;
+    remote.id = 0x7DF;
+    remote.rtr = true;
+    remote.dlc = 4;
+    remote.data[0] = 0xAA;      // Stale bytes that must not be shown
+    frames.append(remote);
+    return frames;
+}
+
+template <typename Paint>
+double medianMs(Paint paint)
+{
+    std::vector<double> times;
+    times.reserve(kRuns);
+    for (int run = 0; run < kRuns; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        paint();
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::nth_element(times.begin(), times.begin() + kRuns / 2, times.end());
+    return times[kRuns / 2];
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+
+    CapturePipeline pipeline;
+    pipeline.replaceFrames(busyFrames());
+    FrameTableModel model;
+    model.refresh(pipeline, FrameFilter());
+    CHECK(model.rowCount() == CapturePipeline::kMaxFrames);
+
+    // The store is newest first: row 0 is the remote frame
+    const QModelIndex remote = model.index(0, FrameTableModel::DataColumn);
+    CHECK(model.data(remote, PayloadDelegate::RemoteRole).toInt() == 4);
+    CHECK(model.data(remote, PayloadDelegate::PayloadRole).isNull());
+    const QModelIndex data = model.index(1, FrameTableModel::DataColumn);
+    CHECK(!model.data(data, PayloadDelegate::RemoteRole).isValid());
+    CHECK(model.data(data, PayloadDelegate::PayloadRole).toByteArray().size() == 8);
+
+    // Set up like the monitor
+    QTableView view;
+    view.setModel(&model);
+    PayloadDelegate *delegate = new PayloadDelegate(&view);
+    view.setItemDelegateForColumn(FrameTableModel::DataColumn, delegate);
+    view.setWordWrap(false);
+    view.verticalHeader()->setDefaultSectionSize(kRowHeight);
+    view.verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    view.horizontalHeader()->setSectionResizeMode(FrameTableModel::DataColumn, QHeaderView::Stretch);
+    view.resize(kScreenWidth, kScreenHeight);
+
+    const int rows = qMin(model.rowCount(), kScreenHeight / kRowHeight);
+    QImage image(kScreenWidth, kScreenHeight, QImage::Format_ARGB32_Premultiplied);
+
+    // The payload column alone, the way the view calls the delegate
+    QStyleOptionViewItem option;
+    option.initFrom(&view);
+    option.widget = &view;
+    option.font = view.font();
+    const double payloadMs = medianMs([&]() {
+        QPainter painter(&image);
+        for (int row = 0; row < rows; row++) {
+            option.rect = QRect(0, row * kRowHeight, kPayloadColumnWidth, kRowHeight);
+            delegate->paint(&painter, option, model.index(row, FrameTableModel::DataColumn));
+        }
+    });
+
+    // Everything on screen: style, grid, header and the text columns
+    const double viewMs = medianMs([&]() { view.render(&image); });
+
+    printf("full-screen paint, %d rows: payload column %.3f ms (budget %.3f ms), whole view %.3f ms\n",
+           rows, payloadMs, kMaxPayloadPaintMs, viewMs);
+    CHECK(payloadMs < kMaxPayloadPaintMs);
+
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
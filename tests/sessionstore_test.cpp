@@ -0,0 +1,210 @@
+// Session file round trips (sessionstore.h): clean shutdown through the
+// index, crash recovery by walking the chunks, reset rotation, the
+// single-writer lock and trace export/import.
+// Plain executable registered with CTest; a non-zero exit code is a failure.
+
+#include "sessionstore.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+const int kRecent = 100;
+const quint64 kBaseNs = 5000000000ULL;     // Capture clock
+
+// Frame i of a test session: three IDs at 10 ms, 20 ms and 40 ms
+CanMessage frame(int i)
+{
+    static const quint32 kIds[] = {0x123, 0x1900140, 0x7DF};
+    CanMessage msg;
+    msg.id = kIds[i % 3];
+    msg.extended = msg.id > CanMessage::kMaxStandardId;
+    msg.timestampNs = kBaseNs + quint64(i / 3) * 10000000ULL * quint64(1 << (i % 3));
+    msg.dlc = quint8(i % 9);
+    msg.tx = i % 5 == 0;
+    for (int b = 0; b < msg.dlc; b++)
+        msg.data[b] = quint8(i + b);
+    return msg;
+}
+
+bool sameFrame(const CanMessage &a, const CanMessage &b)
+{
+    return a.timestampNs == b.timestampNs && a.id == b.id && a.extended == b.extended
+        && a.dlc == b.dlc && a.tx == b.tx && a.rtr == b.rtr && memcmp(a.data, b.data, a.dlc) == 0;
+}
+
+// Appends frames [from, to) in several flushes, so the file has several frame chunks
+void record(SessionStore &store, int from, int to)
+{
+    for (int start = from; start < to; start += 700) {
+        QVector<CanMessage> batch;
+        for (int i = start; i < qMin(to, start + 700); i++)
+            batch.append(frame(i));
+        store.append(batch);
+        store.sync();
+    }
+}
+
+bool tailMatches(const QVector<CanMessage> &recent, int total)
+{
+    if (recent.size() != qMin(total, kRecent))
+        return false;
+    for (int i = 0; i < recent.size(); i++) {
+        if (!sameFrame(recent[i], frame(total - recent.size() + i)))
+            return false;
+    }
+    return true;
+}
+
+// -------------------- RESTORE --------------------
+void testIndexedRestore(const QString &path)
+{
+    {
+        SessionStore store;
+        CHECK(store.open(path, kRecent));
+        CHECK(!store.restored().indexed && store.restored().totalFrames == 0);
+        record(store, 0, 3000);
+        store.setSetting("filter", "0x123");
+        store.setSetting("txProtocol", 1);
+    }   // Clean shutdown writes the index
+
+    SessionStore store;
+    CHECK(store.open(path, kRecent));
+    const SessionStore::Restored &restored = store.restored();
+    CHECK(restored.indexed);
+    CHECK(restored.totalFrames == 3000);
+    CHECK(tailMatches(restored.recentFrames, 3000));
+    CHECK(restored.settings.value("filter").toString() == "0x123");
+    CHECK(restored.settings.value("txProtocol").toInt() == 1);
+
+    const QVector<IdStatistics> stats = store.statistics();
+    CHECK(stats.size() == 3);
+    for (const IdStatistics &s : stats) {
+        CHECK(s.count == 1000 && s.periods == 999);
+        CHECK(s.minPeriodNs == s.maxPeriodNs && s.meanPeriodNs() == s.minPeriodNs);
+    }
+
+    // Appending resumes where the previous run stopped
+    record(store, 3000, 3300);
+    CHECK(store.frameCount() == 3300);
+}
+
+void testCrashRecovery(const QString &path)
+{
+    // The previous test left an index; cut into it like a crash mid-write
+    QFile file(path);
+    CHECK(file.open(QFile::ReadWrite));
+    CHECK(file.resize(file.size() - 5));
+    file.close();
+
+    SessionStore store;
+    CHECK(store.open(path, kRecent));
+    const SessionStore::Restored &restored = store.restored();
+    CHECK(!restored.indexed);
+    CHECK(restored.totalFrames == 3300);
+    CHECK(tailMatches(restored.recentFrames, 3300));
+    CHECK(restored.settings.value("filter").toString() == "0x123");
+}
+
+// -------------------- LOCK AND RESET --------------------
+void testSingleWriter(const QString &path)
+{
+    SessionStore first;
+    CHECK(first.open(path, kRecent));
+
+    SessionStore second;
+    QString error;
+    CHECK(!second.open(path, kRecent, &error));
+    CHECK(!second.isOpen() && !error.isEmpty());
+}
+
+void testResetRotates(const QString &path)
+{
+    {
+        SessionStore store;
+        CHECK(store.open(path, kRecent));
+        const quint64 before = store.restored().totalFrames;
+        CHECK(before > 0);
+        store.reset();
+        record(store, 0, 10);
+        store.sync();
+        CHECK(store.frameCount() == 10);
+    }
+
+    // The old history moved to <path>.1, settings carried over
+    SessionStore previous;
+    CHECK(previous.open(path + ".1", kRecent));
+    CHECK(previous.restored().totalFrames == 3300);
+
+    SessionStore store;
+    CHECK(store.open(path, kRecent));
+    CHECK(store.restored().totalFrames == 10);
+    CHECK(tailMatches(store.restored().recentFrames, 10));
+    CHECK(store.restored().settings.value("filter").toString() == "0x123");
+}
+
+// -------------------- EXPORT / IMPORT --------------------
+void testExportImport(const QString &dir)
+{
+    const QString source = dir + "/export.cansession";
+    const QString trace = dir + "/export.csv";
+    {
+        SessionStore store;
+        CHECK(store.open(source, kRecent));
+        record(store, 0, 2000);
+        QString error;
+        CHECK(store.exportTo(trace, &error));
+        CHECK(error.isEmpty());
+    }
+
+    SessionStore store;
+    CHECK(store.open(dir + "/import.cansession", kRecent));
+    QVector<CanMessage> recent;
+    QString error;
+    CHECK(store.importFrom(trace, &recent, &error));
+    CHECK(store.frameCount() == 2000);
+    CHECK(tailMatches(recent, 2000));
+
+    // Cancelled before the first chunk
+    std::atomic<bool> cancel(true);
+    CHECK(!store.exportTo(dir + "/cancelled.csv", &error, &cancel));
+    CHECK(error == "Cancelled");
+}
+
+} // namespace
+
+int main()
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        fprintf(stderr, "cannot create a temporary directory\n");
+        return 1;
+    }
+    const QString path = dir.path() + "/test.cansession";
+
+    testIndexedRestore(path);
+    testCrashRecovery(path);
+    testSingleWriter(path);
+    testResetRotates(path);
+    testExportImport(dir.path());
+
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
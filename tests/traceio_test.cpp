@@ -0,0 +1,223 @@
+// Trace reader/writer round trips and parser edge cases (traceio.h).
+// Plain executable registered with CTest; a non-zero exit code is a failure.
+
+#include "traceio.h"
+
+#include <QBuffer>
+#include <QByteArray>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+const quint64 kStartNs = 1700000000123456000ULL;   // Whole microseconds, every format keeps them
+
+CanMessage frame(quint64 offsetUs, quint32 id, bool extended, int dlc, bool tx = false, bool rtr = false)
+{
+    CanMessage msg;
+    msg.timestampNs = kStartNs + offsetUs * 1000;
+    msg.id = id;
+    msg.extended = extended;
+    msg.dlc = quint8(dlc);
+    msg.tx = tx;
+    msg.rtr = rtr;
+    for (int i = 0; i < dlc && !rtr; i++)
+        msg.data[i] = quint8(0x11 * (i + 1));
+    return msg;
+}
+
+QVector<CanMessage> sampleFrames(bool withRtr)
+{
+    QVector<CanMessage> frames;
+    frames.append(frame(0, 0x1900140, true, 8));
+    frames.append(frame(250, 0x7DF, false, 3, true));
+    frames.append(frame(1000, 0x123, false, 0));
+    frames.append(frame(1000500, CanMessage::kMaxExtendedId, true, 5));
+    frames.append(frame(2000000, 0x001, true, 1));    // Extended despite the small ID
+    if (withRtr)
+        frames.append(frame(3000001, 0x7FF, false, 4, false, true));
+    return frames;
+}
+
+QVector<CanMessage> readAll(const QByteArray &text, TraceFormat format, qint64 *skipped = nullptr)
+{
+    QByteArray bytes = text;
+    QBuffer buffer(&bytes);
+    buffer.open(QBuffer::ReadOnly);
+    TraceReader reader(&buffer, format);
+    QVector<CanMessage> all, chunk;
+    while (reader.readChunk(chunk, 3))
+        all += chunk;
+    if (skipped)
+        *skipped = reader.skippedLines();
+    return all;
+}
+
+QByteArray writeAll(const QVector<CanMessage> &frames, TraceFormat format)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QBuffer::WriteOnly);
+    TraceWriter writer(&buffer, format);
+    CHECK(writer.write(frames));
+    CHECK(writer.finish());
+    return bytes;
+}
+
+bool sameFrame(const CanMessage &a, const CanMessage &b, bool compareTx, bool compareRtr)
+{
+    return a.timestampNs == b.timestampNs && a.id == b.id && a.extended == b.extended && a.dlc == b.dlc
+        && (!compareTx || a.tx == b.tx) && (!compareRtr || a.rtr == b.rtr)
+        && (a.rtr || memcmp(a.data, b.data, a.dlc) == 0);
+}
+
+// -------------------- ROUND TRIPS --------------------
+void testRoundTrip(TraceFormat format, bool keepsTx, bool keepsRtr)
+{
+    const QVector<CanMessage> frames = sampleFrames(keepsRtr);
+    qint64 skipped = -1;
+    const QVector<CanMessage> back = readAll(writeAll(frames, format), format, &skipped);
+    CHECK(back.size() == frames.size());
+    for (int i = 0; i < qMin(back.size(), frames.size()); i++)
+        CHECK(sameFrame(back[i], frames[i], keepsTx, keepsRtr));
+    // Header and trailer lines that are neither frames nor header settings
+    CHECK(skipped == (format == TraceFormat::Asc ? 4 : format == TraceFormat::Csv ? 1 : 0));
+}
+
+void testChainedConversion()
+{
+    // candump -> ASC -> CSV keeps every field the formats share
+    const QVector<CanMessage> frames = sampleFrames(false);
+    const QVector<CanMessage> asc = readAll(writeAll(frames, TraceFormat::Candump), TraceFormat::Candump);
+    const QVector<CanMessage> csv = readAll(writeAll(asc, TraceFormat::Asc), TraceFormat::Asc);
+    const QVector<CanMessage> back = readAll(writeAll(csv, TraceFormat::Csv), TraceFormat::Csv);
+    CHECK(back.size() == frames.size());
+    for (int i = 0; i < qMin(back.size(), frames.size()); i++)
+        CHECK(sameFrame(back[i], frames[i], false, false));
+}
+
+// -------------------- ASC HEADER --------------------
+void testAscRelativeTimestamps()
+{
+    const QByteArray text =
+        "date Mon Nov 13 10:20:30.000 am 2023\n"
+        "base hex  timestamps relative\n"
+        "Begin Triggerblock Mon Nov 13 10:20:30.000 am 2023\n"
+        "   0.000000 Start of measurement\n"
+        "   0.001000 1  123             Rx   d 1 11\n"
+        "   0.000500 1  Error frame\n"
+        "   0.002000 1  1900140x        Tx   d 2 22 33\n"
+        "End TriggerBlock\n";
+    const QVector<CanMessage> frames = readAll(text, TraceFormat::Asc);
+    CHECK(frames.size() == 2);
+    if (frames.size() == 2) {
+        // Deltas to the previous event, including lines that are not frames
+        CHECK(frames[1].timestampNs - frames[0].timestampNs == 2500000);
+        CHECK(frames[0].id == 0x123 && !frames[0].extended);
+        CHECK(frames[1].id == 0x1900140 && frames[1].extended && frames[1].tx);
+    }
+
+    // The same lines with absolute timestamps
+    QByteArray absolute = text;
+    absolute.replace("timestamps relative", "timestamps absolute");
+    const QVector<CanMessage> plain = readAll(absolute, TraceFormat::Asc);
+    CHECK(plain.size() == 2 && plain[1].timestampNs - plain[0].timestampNs == 1000000);
+
+    QByteArray headerBytes = text;
+    QBuffer buffer(&headerBytes);
+    buffer.open(QBuffer::ReadOnly);
+    const TraceHeader header = TraceReader::readHeader(&buffer, TraceFormat::Asc);
+    CHECK(header.relativeTimestamps && !header.decimalIds && header.startEpochNs > 0);
+}
+
+void testAscDecimalIds()
+{
+    const QByteArray text =
+        "base dec  timestamps absolute\n"
+        "   0.001000 1  291             Rx   d 1 11\n"
+        "   0.002000 1  536870911x      Rx   d 0\n"
+        "   0.003000 1  536870912x      Rx   d 0\n";
+    qint64 skipped = 0;
+    const QVector<CanMessage> frames = readAll(text, TraceFormat::Asc, &skipped);
+    CHECK(frames.size() == 2 && skipped == 1);
+    CHECK(frames.size() == 2 && frames[0].id == 0x123 && frames[1].id == CanMessage::kMaxExtendedId);
+}
+
+// -------------------- LINE AND ID LIMITS --------------------
+void testOverlongLines()
+{
+    // A line longer than the reader's buffer is one skipped line, not several
+    const QByteArray junk(2000, '7');
+    const QByteArray candump = "(1.000000) can0 123#11\n" + junk + "\n(2.000000) can0 124#22\n";
+    qint64 skipped = 0;
+    QVector<CanMessage> frames = readAll(candump, TraceFormat::Candump, &skipped);
+    CHECK(frames.size() == 2 && skipped == 1);
+
+    // Even when the reader's 512-byte buffer would split it where the rest
+    // parses as a frame of its own
+    const QByteArray head = "(1.000000) can0 123#" + QByteArray(511 - 20, '0');
+    const QByteArray tricky = head + "(3.000000) can0 125#33\n(2.000000) can0 124#22\r\n";
+    frames = readAll(tricky, TraceFormat::Candump, &skipped);
+    CHECK(frames.size() == 1 && skipped == 1);
+    CHECK(frames.size() == 1 && frames[0].id == 0x124);
+
+    // Between the ASC header and the frames
+    const QByteArray asc = "base dec  timestamps absolute\n" + QByteArray(700, 'x') + "\n"
+                           "   0.001000 1  291             Rx   d 1 11\n";
+    frames = readAll(asc, TraceFormat::Asc, &skipped);
+    CHECK(frames.size() == 1 && frames[0].id == 0x123 && skipped == 1);
+}
+
+void testIdRange()
+{
+    qint64 skipped = 0;
+    QVector<CanMessage> frames = readAll("(1.0) can0 1FFFFFFF#11\n"
+                                         "(1.0) can0 20000000#11\n"
+                                         "(1.0) can0 FFFFFFFF#11\n"
+                                         "(1.0) can0 100000000#11\n",
+                                         TraceFormat::Candump, &skipped);
+    CHECK(frames.size() == 1 && skipped == 3);
+
+    frames = readAll("1,RX,0x1FFFFFFF,1,11\n"
+                     "1,RX,0x20000000,1,11\n"
+                     "1,RX,0x100000000,1,11\n",
+                     TraceFormat::Csv, &skipped);
+    CHECK(frames.size() == 1 && skipped == 2);
+
+    frames = readAll("   0.001000 1  1FFFFFFFx       Rx   d 1 11\n"
+                     "   0.001000 1  20000000x       Rx   d 1 11\n"
+                     "   0.001000 1  100000000x      Rx   d 1 11\n",
+                     TraceFormat::Asc, &skipped);
+    CHECK(frames.size() == 1 && skipped == 2);
+}
+
+} // namespace
+
+int main()
+{
+    testRoundTrip(TraceFormat::Candump, false, true);
+    testRoundTrip(TraceFormat::Asc, true, true);
+    testRoundTrip(TraceFormat::Csv, true, false);
+    testChainedConversion();
+    testAscRelativeTimestamps();
+    testAscDecimalIds();
+    testOverlongLines();
+    testIdRange();
+
+    if (failures)
+        fprintf(stderr, "%d check(s) failed\n", failures);
+    else
+        printf("all checks passed\n");
+    return failures ? 1 : 0;
+}
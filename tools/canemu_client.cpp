@@ -0,0 +1,155 @@
+// Headless frame server client: connects to a running emulator, optionally
+// installs filters, and prints the received frames as a candump log.
+//
+//   canemu_client [--local <name>] [--port <n>] [--filter <id>:<mask>]...
+//                 [--count <n>] [--stall <seconds>]
+//
+// --stall stops reading for a while after connecting so the server's
+// backlog grows past FrameServer::kMaxBacklogBytes; the server then drops
+// the connection, which is reported on stderr.
+
+#include "canrecord.h"
+#include "captureclock.h"
+#include "frameserver.h"
+#include "traceio.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <cstdio>
+
+static const char kHello[] = "CANEMU01";
+static const int kHelloSize = sizeof(kHello) - 1;
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints frames streamed by the CAN emulator's frame server.");
+    parser.addHelpOption();
+    QCommandLineOption localOption("local", "Connect to the local socket <name>.", "name");
+    QCommandLineOption portOption("port", "Connect to TCP port <n> on 127.0.0.1.", "n",
+                                  QString::number(FrameServer::kDefaultTcpPort));
+    QCommandLineOption filterOption("filter", "Only receive IDs matching <id>:<mask>, repeatable.", "id:mask");
+    QCommandLineOption countOption("count", "Exit after <n> frames.", "n");
+    QCommandLineOption stallOption("stall", "Stop reading for <seconds> after connecting.", "seconds");
+    parser.addOptions({localOption, portOption, filterOption, countOption, stallOption});
+    parser.process(app);
+
+    // -------------------- CONNECT --------------------
+    QIODevice *device;
+    QLocalSocket *localSocket = nullptr;
+    QTcpSocket *tcpSocket = nullptr;
+    if (parser.isSet(localOption)) {
+        localSocket = new QLocalSocket(&app);
+        localSocket->connectToServer(parser.value(localOption));
+        if (!localSocket->waitForConnected(3000)) {
+            fprintf(stderr, "connect: %s\n", qPrintable(localSocket->errorString()));
+            return 1;
+        }
+        device = localSocket;
+    } else {
+        tcpSocket = new QTcpSocket(&app);
+        tcpSocket->connectToHost(QHostAddress::LocalHost, quint16(parser.value(portOption).toUInt()));
+        if (!tcpSocket->waitForConnected(3000)) {
+            fprintf(stderr, "connect: %s\n", qPrintable(tcpSocket->errorString()));
+            return 1;
+        }
+        device = tcpSocket;
+    }
+
+    for (const QString &filter : parser.values(filterOption)) {
+        const QStringList parts = filter.split(':');
+        bool idOk = false;
+        bool maskOk = false;
+        const quint32 id = parts.value(0).toUInt(&idOk, 0);
+        const quint32 mask = parts.size() == 2 ? parts[1].toUInt(&maskOk, 0) : 0;
+        if (!idOk || !maskOk) {
+            fprintf(stderr, "invalid filter '%s', expected <id>:<mask>\n", qPrintable(filter));
+            return 1;
+        }
+        device->write(QString("FILTER 0x%1 0x%2\n").arg(id, 0, 16).arg(mask, 0, 16).toLatin1());
+    }
+
+    // -------------------- RECEIVE --------------------
+    QFile out;
+    out.open(stdout, QFile::WriteOnly);
+    TraceWriter writer(&out, TraceFormat::Candump);
+
+    const qint64 maxFrames = parser.isSet(countOption) ? parser.value(countOption).toLongLong() : -1;
+    qint64 frames = 0;
+    QByteArray buffer;
+    bool helloSeen = false;
+    bool stalled = false;
+
+    auto readRecords = [&]() {
+        if (stalled)
+            return;
+        buffer.append(device->readAll());
+
+        if (!helloSeen) {
+            if (buffer.size() < kHelloSize)
+                return;
+            if (!buffer.startsWith(kHello)) {
+                fprintf(stderr, "not a frame server\n");
+                app.exit(1);
+                return;
+            }
+            buffer.remove(0, kHelloSize);
+            helloSeen = true;
+        }
+
+        const int records = int(buffer.size()) / CanRecord::kSize;
+        const uchar *in = reinterpret_cast<const uchar*>(buffer.constData());
+        for (int i = 0; i < records && frames != maxFrames; i++, frames++) {
+            CanMessage msg = CanRecord::read(in + i * CanRecord::kSize);
+            msg.timestampNs = CaptureClock::toEpochNs(msg.timestampNs);
+            writer.write(msg);
+        }
+        buffer.remove(0, records * CanRecord::kSize);
+
+        if (frames == maxFrames)
+            app.quit();
+    };
+
+    QObject::connect(device, &QIODevice::readyRead, &app, readRecords);
+
+    auto onDisconnected = [&]() {
+        fprintf(stderr, "disconnected by server after %lld frames\n", frames);
+        app.exit(2);
+    };
+    if (localSocket)
+        QObject::connect(localSocket, &QLocalSocket::disconnected, &app, onDisconnected);
+    else
+        QObject::connect(tcpSocket, &QTcpSocket::disconnected, &app, onDisconnected);
+
+    if (parser.isSet(stallOption)) {
+        // Keep Qt from draining the kernel buffer so the backlog builds up
+        // on the server side
+        stalled = true;
+        if (localSocket)
+            localSocket->setReadBufferSize(CanRecord::kSize);
+        else
+            tcpSocket->setReadBufferSize(CanRecord::kSize);
+        fprintf(stderr, "stalling for %s s\n", qPrintable(parser.value(stallOption)));
+
+        QTimer::singleShot(int(parser.value(stallOption).toDouble() * 1000), &app, [&]() {
+            stalled = false;
+            if (localSocket)
+                localSocket->setReadBufferSize(0);
+            else
+                tcpSocket->setReadBufferSize(0);
+            fprintf(stderr, "reading again\n");
+            readRecords();
+        });
+    }
+
+    const int result = app.exec();
+    writer.finish();
+    return result;
+}
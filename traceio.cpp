@@ -0,0 +1,621 @@
+#include "traceio.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+
+#include <cstring>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+const int kMaxLineLength = 512;          // reader line buffer, longer lines are skipped
+const int kMaxFormattedLength = 128;     // longest written line (ASC, 8 data bytes) is ~70
+const int kMaxHeaderLines = 32;          // ASC header scan limit
+const int kWriteBufferSize = 1 << 20;   // flush threshold
+const int kChunkFrames = 16384;         // frames per pipeline chunk
+const size_t kMaxQueuedChunks = 4;      // bounds conversion memory
+
+const char kHexDigits[] = "0123456789ABCDEF";
+
+// -------------------- PARSING HELPERS --------------------
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+void skipSpaces(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+}
+
+bool expect(const char *&p, const char *end, char c)
+{
+    if (p >= end || *p != c)
+        return false;
+    p++;
+    return true;
+}
+
+// Parses up to 8 hex digits, returns the number of digits consumed
+int parseHex(const char *&p, const char *end, quint32 &value)
+{
+    value = 0;
+    int digits = 0;
+    int v;
+    while (p < end && digits < 8 && (v = hexValue(*p)) >= 0) {
+        value = (value << 4) | quint32(v);
+        p++;
+        digits++;
+    }
+    return digits;
+}
+
+bool parseDecimal(const char *&p, const char *end, quint64 &value)
+{
+    value = 0;
+    const char *start = p;
+    while (p < end && isDigit(*p))
+        value = value * 10 + quint64(*p++ - '0');
+    return p != start;
+}
+
+// "seconds[.fraction]" -> nanoseconds
+bool parseSeconds(const char *&p, const char *end, quint64 &ns)
+{
+    quint64 seconds;
+    if (!parseDecimal(p, end, seconds))
+        return false;
+
+    quint64 fraction = 0;
+    int digits = 0;
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && isDigit(*p)) {
+            if (digits < 9) {
+                fraction = fraction * 10 + quint64(*p - '0');
+                digits++;
+            }
+            p++;
+        }
+    }
+    for (; digits < 9; digits++)
+        fraction *= 10;
+
+    ns = seconds * 1000000000ULL + fraction;
+    return true;
+}
+
+// Space separated hex bytes ("11 22 33"), at most 8
+bool parseByteList(const char *&p, const char *end, CanMessage &msg, int expected)
+{
+    msg.dlc = 0;
+    while (msg.dlc < 8) {
+        skipSpaces(p, end);
+        if (p + 1 >= end || hexValue(p[0]) < 0 || hexValue(p[1]) < 0)
+            break;
+        msg.data[msg.dlc++] = quint8(hexValue(p[0]) << 4 | hexValue(p[1]));
+        p += 2;
+    }
+    return expected < 0 || msg.dlc == expected;
+}
+
+// Reads one line and strips the line ending, -1 at the end of the input. A
+// line that does not fit the buffer is consumed up to its end and flagged,
+// so it counts as one line.
+qint64 readTraceLine(QIODevice *device, char *line, qint64 size, bool &overlong)
+{
+    overlong = false;
+    qint64 length = device->readLine(line, size);
+    if (length <= 0)
+        return -1;
+
+    bool partial = line[length - 1] != '\n';
+    while (partial) {
+        char rest[kMaxLineLength];
+        const qint64 more = device->readLine(rest, sizeof(rest));
+        if (more <= 0)
+            break;
+        partial = rest[more - 1] != '\n';
+        for (qint64 i = 0; i < more && !overlong; i++)
+            overlong = rest[i] != '\n' && rest[i] != '\r';
+    }
+
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+        length--;
+    return length;
+}
+
+// -------------------- FORMATTING HELPERS --------------------
+char *putHex(char *out, quint32 value, int digits)
+{
+    for (int i = digits - 1; i >= 0; i--)
+        *out++ = kHexDigits[(value >> (i * 4)) & 0xF];
+    return out;
+}
+
+char *putDecimal(char *out, quint64 value, int minDigits = 1)
+{
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = char('0' + value % 10);
+        value /= 10;
+    } while (value || n < minDigits);
+    while (n)
+        *out++ = tmp[--n];
+    return out;
+}
+
+// nanoseconds -> "seconds.micros"
+char *putSeconds(char *out, quint64 ns)
+{
+    out = putDecimal(out, ns / 1000000000ULL);
+    *out++ = '.';
+    return putDecimal(out, (ns % 1000000000ULL) / 1000, 6);
+}
+
+char *putString(char *out, const char *text)
+{
+    while (*text)
+        *out++ = *text++;
+    return out;
+}
+
+} // namespace
+
+// -------------------- FORMAT DETECTION --------------------
+TraceFormat traceFormatForPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "log")
+        return TraceFormat::Candump;
+    if (suffix == "asc")
+        return TraceFormat::Asc;
+    if (suffix == "csv")
+        return TraceFormat::Csv;
+    return TraceFormat::Unknown;
+}
+
+// -------------------- READER --------------------
+TraceReader::TraceReader(QIODevice *device, TraceFormat format)
+    : device(device)
+    , format(format)
+    , skipped(0)
+    , endOffset(-1)
+    , previousNs(0)
+{
+}
+
+bool TraceReader::readChunk(QVector<CanMessage> &chunk, int maxFrames)
+{
+    chunk.clear();
+
+    char line[kMaxLineLength];
+    while (chunk.size() < maxFrames) {
+        if (endOffset >= 0 && device->pos() >= endOffset)
+            break;
+
+        bool overlong;
+        const qint64 length = readTraceLine(device, line, sizeof(line), overlong);
+        if (length < 0)
+            break;
+        if (overlong) {
+            skipped++;
+            continue;
+        }
+        if (length == 0)
+            continue;
+
+        if (format == TraceFormat::Asc && applyHeaderLine(line, int(length), traceHeader))
+            continue;
+
+        CanMessage msg;
+        if (parseLine(line, int(length), msg))
+            chunk.append(msg);
+        else
+            skipped++;
+    }
+
+    return !chunk.isEmpty();
+}
+
+TraceHeader TraceReader::readHeader(QIODevice *device, TraceFormat format)
+{
+    TraceHeader header;
+    if (format != TraceFormat::Asc)
+        return header;
+
+    // The header precedes "Begin Triggerblock", give up after a few lines
+    char line[kMaxLineLength];
+    for (int i = 0; i < kMaxHeaderLines; i++) {
+        bool overlong;
+        const qint64 length = readTraceLine(device, line, sizeof(line), overlong);
+        if (length < 0)
+            break;
+        if (overlong)
+            continue;
+        if (length >= 5 && memcmp(line, "Begin", 5) == 0)
+            break;
+        applyHeaderLine(line, int(length), header);
+    }
+    return header;
+}
+
+bool TraceReader::applyHeaderLine(const char *line, int length, TraceHeader &header)
+{
+    // e.g. "base hex  timestamps absolute"
+    if (length > 5 && memcmp(line, "base ", 5) == 0) {
+        const QByteArray words = QByteArray(line + 5, length - 5).simplified();
+        header.decimalIds = words.startsWith("dec");
+        header.relativeTimestamps = words.contains("timestamps relative");
+        return true;
+    }
+
+    if (length > 5 && memcmp(line, "date ", 5) == 0) {
+        // e.g. "Mon Nov 13 10:20:30.123 am 2023", local time
+        static const char *const kDateFormats[] = {
+            "ddd MMM d hh:mm:ss.zzz ap yyyy",
+            "ddd MMM d hh:mm:ss ap yyyy",
+            "ddd MMM d HH:mm:ss.zzz yyyy",
+            "ddd MMM d HH:mm:ss yyyy",
+        };
+        const QString text = QString::fromLatin1(line + 5, length - 5).simplified();
+        for (const char *dateFormat : kDateFormats) {
+            QDateTime date = QLocale::c().toDateTime(text, QString::fromLatin1(dateFormat));
+            if (date.isValid()) {
+                header.startEpochNs = quint64(qMax<qint64>(0, date.toMSecsSinceEpoch())) * 1000000ULL;
+                break;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool TraceReader::parseLine(const char *line, int length, CanMessage &msg)
+{
+    const char *p = line;
+    const char *end = line + length;
+    quint64 number;
+    int digits;
+
+    switch (format) {
+    case TraceFormat::Candump:
+        // (1700000000.123456) can0 1900140#1122334455667788
+        if (!expect(p, end, '(') || !parseSeconds(p, end, msg.timestampNs) || !expect(p, end, ')'))
+            return false;
+        skipSpaces(p, end);
+        while (p < end && *p != ' ')   // interface name
+            p++;
+        skipSpaces(p, end);
+        digits = parseHex(p, end, msg.id);
+        if (!digits || msg.id > CanMessage::kMaxExtendedId || !expect(p, end, '#'))
+            return false;
+        // 3 digits for standard, 8 for extended frames
+        msg.extended = digits > 3 || msg.id > CanMessage::kMaxStandardId;
+        msg.dlc = 0;
+        if (p < end && *p == 'R') {
+            // Remote frame: "R" with an optional length digit
+            msg.rtr = true;
+            p++;
+            if (p < end && *p >= '0' && *p <= '8')
+                msg.dlc = quint8(*p++ - '0');
+        }
+        while (!msg.rtr && msg.dlc < 8 && p + 1 < end && hexValue(p[0]) >= 0 && hexValue(p[1]) >= 0) {
+            msg.data[msg.dlc++] = quint8(hexValue(p[0]) << 4 | hexValue(p[1]));
+            p += 2;
+        }
+        skipSpaces(p, end);
+        msg.tx = (p < end && *p == 'T');  // candump -x direction marker
+        return true;
+
+    case TraceFormat::Asc:
+        //    0.001234 1  1900140x        Rx   d 8 11 22 33 44 55 66 77 88
+        skipSpaces(p, end);
+        if (!parseSeconds(p, end, msg.timestampNs))
+            return false;
+        if (traceHeader.relativeTimestamps) {
+            // Every event line advances the clock, frames or not
+            msg.timestampNs += previousNs;
+            previousNs = msg.timestampNs;
+        }
+        skipSpaces(p, end);
+        if (!parseDecimal(p, end, number))  // channel
+            return false;
+        skipSpaces(p, end);
+        if (traceHeader.decimalIds) {
+            if (!parseDecimal(p, end, number) || number > CanMessage::kMaxExtendedId)
+                return false;
+            msg.id = quint32(number);
+        } else if (!parseHex(p, end, msg.id) || msg.id > CanMessage::kMaxExtendedId) {
+            return false;
+        }
+        msg.extended = msg.id > CanMessage::kMaxStandardId;
+        if (p < end && *p == 'x') {
+            msg.extended = true;
+            p++;
+        }
+        skipSpaces(p, end);
+        if (end - p < 2 || (p[0] != 'R' && p[0] != 'T') || p[1] != 'x')
+            return false;
+        msg.tx = (p[0] == 'T');
+        msg.timestampNs += traceHeader.startEpochNs;
+        p += 2;
+        skipSpaces(p, end);
+        // "d" data frame, "r" remote frame without payload
+        if (p < end && *p == 'r') {
+            msg.rtr = true;
+            p++;
+        } else if (!expect(p, end, 'd')) {
+            return false;
+        }
+        skipSpaces(p, end);
+        if (!parseDecimal(p, end, number) || number > 8)
+            return false;
+        if (msg.rtr) {
+            msg.dlc = quint8(number);
+            return true;
+        }
+        return parseByteList(p, end, msg, int(number));
+
+    case TraceFormat::Csv:
+        // 1700000000123456789,RX,0x1900140,8,11 22 33 44 55 66 77 88
+        if (!parseDecimal(p, end, msg.timestampNs) || !expect(p, end, ','))
+            return false;
+        if (end - p < 3 || p[1] != 'X' || (p[0] != 'R' && p[0] != 'T') || p[2] != ',')
+            return false;
+        msg.tx = (p[0] == 'T');
+        p += 3;
+        if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X'))
+            p += 2;
+        digits = parseHex(p, end, msg.id);
+        if (!digits || msg.id > CanMessage::kMaxExtendedId || !expect(p, end, ','))
+            return false;
+        msg.extended = digits > 3 || msg.id > CanMessage::kMaxStandardId;
+        if (!parseDecimal(p, end, number) || number > 8 || !expect(p, end, ','))
+            return false;
+        return parseByteList(p, end, msg, int(number));
+
+    case TraceFormat::Unknown:
+        break;
+    }
+    return false;
+}
+
+// -------------------- WRITER --------------------
+TraceWriter::TraceWriter(QIODevice *device, TraceFormat format)
+    : device(device)
+    , format(format)
+    , headerWritten(false)
+    , finished(false)
+    , baseTimestampNs(0)
+{
+    buffer.reserve(kWriteBufferSize + kMaxFormattedLength);
+}
+
+TraceWriter::~TraceWriter()
+{
+    if (!finished)
+        finish();
+}
+
+void TraceWriter::writeHeader(const CanMessage &first)
+{
+    headerWritten = true;
+    // The ASC date line has millisecond resolution, times are relative to it
+    baseTimestampNs = first.timestampNs / 1000000ULL * 1000000ULL;
+
+    if (format == TraceFormat::Asc) {
+        QDateTime start = QDateTime::fromMSecsSinceEpoch(qint64(baseTimestampNs / 1000000));
+        QString date = QLocale::c().toString(start, "ddd MMM dd hh:mm:ss.zzz ap yyyy");
+        buffer.append("date " + date.toLatin1() + "\n");
+        buffer.append("base hex  timestamps absolute\n");
+        buffer.append("internal events logged\n");
+        buffer.append("Begin Triggerblock " + date.toLatin1() + "\n");
+        buffer.append("   0.000000 Start of measurement\n");
+    } else if (format == TraceFormat::Csv) {
+        buffer.append("timestamp_ns,direction,id,dlc,data\n");
+    }
+}
+
+bool TraceWriter::write(const CanMessage &msg)
+{
+    if (!headerWritten)
+        writeHeader(msg);
+
+    char line[kMaxFormattedLength];
+    char *out = line;
+    const int idDigits = msg.extended ? 8 : 3;
+
+    switch (format) {
+    case TraceFormat::Candump:
+        *out++ = '(';
+        out = putSeconds(out, msg.timestampNs);
+        out = putString(out, ") can0 ");
+        out = putHex(out, msg.id, idDigits);
+        *out++ = '#';
+        if (msg.rtr) {
+            *out++ = 'R';
+            if (msg.dlc)
+                *out++ = char('0' + msg.dlc);
+            break;
+        }
+        for (int i = 0; i < msg.dlc; i++)
+            out = putHex(out, msg.data[i], 2);
+        break;
+
+    case TraceFormat::Asc: {
+        quint64 relative = msg.timestampNs >= baseTimestampNs ? msg.timestampNs - baseTimestampNs : 0;
+        char *start = out;
+        out = putSeconds(out, relative);
+        // Right-align the timestamp in an 11 character column like CANalyzer
+        int width = int(out - start);
+        if (width < 11) {
+            int pad = 11 - width;
+            memmove(start + pad, start, size_t(width));
+            memset(start, ' ', size_t(pad));
+            out += pad;
+        }
+        out = putString(out, " 1  ");
+        out = putHex(out, msg.id, idDigits);
+        if (msg.extended)
+            *out++ = 'x';
+        out = putString(out, msg.tx ? "        Tx   " : "        Rx   ");
+        out = putString(out, msg.rtr ? "r " : "d ");
+        out = putDecimal(out, msg.dlc);
+        for (int i = 0; i < msg.dlc && !msg.rtr; i++) {
+            *out++ = ' ';
+            out = putHex(out, msg.data[i], 2);
+        }
+        break;
+    }
+
+    case TraceFormat::Csv:
+        out = putDecimal(out, msg.timestampNs);
+        out = putString(out, msg.tx ? ",TX,0x" : ",RX,0x");
+        out = putHex(out, msg.id, idDigits);
+        *out++ = ',';
+        out = putDecimal(out, msg.dlc);
+        *out++ = ',';
+        for (int i = 0; i < msg.dlc; i++) {
+            if (i)
+                *out++ = ' ';
+            out = putHex(out, msg.data[i], 2);
+        }
+        break;
+
+    case TraceFormat::Unknown:
+        return false;
+    }
+
+    *out++ = '\n';
+    buffer.append(line, int(out - line));
+
+    if (buffer.size() >= kWriteBufferSize)
+        return flushBuffer();
+    return true;
+}
+
+bool TraceWriter::write(const QVector<CanMessage> &chunk)
+{
+    for (const CanMessage &msg : chunk) {
+        if (!write(msg))
+            return false;
+    }
+    return true;
+}
+
+bool TraceWriter::finish()
+{
+    finished = true;
+    if (format == TraceFormat::Asc && headerWritten)
+        buffer.append("End TriggerBlock\n");
+    return flushBuffer();
+}
+
+bool TraceWriter::flushBuffer()
+{
+    if (buffer.isEmpty())
+        return true;
+    bool ok = device->write(buffer) == buffer.size();
+    buffer.clear();
+    return ok;
+}
+
+// -------------------- CONVERTER --------------------
+bool TraceConverter::convert(const QString &inputPath, const QString &outputPath, QString *error,
+                             const std::atomic<bool> *cancel)
+{
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    const TraceFormat inputFormat = traceFormatForPath(inputPath);
+    const TraceFormat outputFormat = traceFormatForPath(outputPath);
+    if (inputFormat == TraceFormat::Unknown || outputFormat == TraceFormat::Unknown)
+        return fail("Unsupported trace format (use .log, .asc or .csv)");
+
+    QFile input(inputPath);
+    if (!input.open(QFile::ReadOnly))
+        return fail(input.errorString());
+
+    QFile output(outputPath);
+    if (!output.open(QFile::WriteOnly | QFile::Truncate))
+        return fail(output.errorString());
+
+    TraceReader reader(&input, inputFormat);
+    TraceWriter writer(&output, outputFormat);
+
+    // Parser thread -> bounded queue -> writer (this thread)
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<QVector<CanMessage>> queue;
+    bool parsingDone = false;
+    bool writeFailed = false;
+    bool stopped = false;       // Writer gave up, failed or cancelled
+
+    std::thread parser([&]() {
+        QVector<CanMessage> chunk;
+        chunk.reserve(kChunkFrames);
+        while (reader.readChunk(chunk, kChunkFrames)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return queue.size() < kMaxQueuedChunks || stopped; });
+            if (stopped)
+                break;
+            queue.push_back(std::move(chunk));
+            changed.notify_all();
+            chunk = QVector<CanMessage>();
+            chunk.reserve(kChunkFrames);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        parsingDone = true;
+        changed.notify_all();
+    });
+
+    for (;;) {
+        QVector<CanMessage> chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return !queue.empty() || parsingDone; });
+            if (queue.empty())
+                break;
+            chunk = std::move(queue.front());
+            queue.pop_front();
+            changed.notify_all();
+        }
+        const bool cancelled = cancel && *cancel;
+        if (cancelled || !writer.write(chunk)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            writeFailed = !cancelled;
+            stopped = true;
+            changed.notify_all();
+            break;
+        }
+    }
+
+    parser.join();
+
+    if (stopped && !writeFailed)
+        return fail("Cancelled");
+    if (writeFailed || !writer.finish())
+        return fail(output.errorString());
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef TRACEIO_H
+#define TRACEIO_H
+
+#include "canmessage.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+class QIODevice;
+
+enum class TraceFormat {
+    Unknown,
+    Candump,   // candump -l:  (1700000000.123456) can0 1900140#1122334455667788
+    Asc,       // Vector ASC:  0.001234 1  1900140x        Rx   d 8 11 22 33 44 55 66 77 88
+    Csv        // timestamp_ns,direction,id,dlc,data
+};
+
+// Trace files carry wall-clock time: CanMessage::timestampNs is in
+// nanoseconds since the Unix epoch on both the reader and writer side.
+
+// Header state that changes how frame lines are read. Only ASC has one:
+// "base hex|dec" selects the ID base and "date ..." the measurement start,
+// which ASC timestamps are relative to. With "timestamps relative" each
+// timestamp is the delta to the previous event instead, so such a file can
+// only be read from the start.
+struct TraceHeader {
+    bool decimalIds = false;
+    bool relativeTimestamps = false;
+    quint64 startEpochNs = 0;
+};
+
+// Guess the format from the file extension (.log, .asc, .csv)
+TraceFormat traceFormatForPath(const QString &path);
+
+// Streaming trace parser. Reads line by line from the device, so memory use
+// does not depend on the trace size.
+class TraceReader
+{
+public:
+    TraceReader(QIODevice *device, TraceFormat format);
+
+    // Appends up to maxFrames frames to chunk (cleared first).
+    // Returns false once the end of the input is reached and nothing was read.
+    // A line longer than the line buffer is skipped as a whole.
+    bool readChunk(QVector<CanMessage> &chunk, int maxFrames);
+
+    qint64 skippedLines() const { return skipped; }
+
+    // Header lines are applied as they are read. A reader starting mid-file
+    // gets them from readHeader() on the same file.
+    static TraceHeader readHeader(QIODevice *device, TraceFormat format);
+    const TraceHeader &header() const { return traceHeader; }
+    void setHeader(const TraceHeader &header) { traceHeader = header; }
+
+    // Stop before any line starting at or after this device offset, so a
+    // file can be split into byte ranges read by independent readers
+    void setEndOffset(qint64 offset) { endOffset = offset; }
+
+private:
+    bool parseLine(const char *line, int length, CanMessage &msg);
+    static bool applyHeaderLine(const char *line, int length, TraceHeader &header);
+
+    QIODevice *device;
+    TraceFormat format;
+    TraceHeader traceHeader;
+    qint64 skipped;
+    qint64 endOffset;
+    quint64 previousNs;     // Last event time, for relative ASC timestamps
+};
+
+// Streaming trace writer with a fixed-size output buffer.
+class TraceWriter
+{
+public:
+    TraceWriter(QIODevice *device, TraceFormat format);
+    ~TraceWriter();
+
+    bool write(const CanMessage &msg);
+    bool write(const QVector<CanMessage> &chunk);
+    bool finish(); // Writes the trailer (ASC) and flushes
+
+private:
+    void writeHeader(const CanMessage &first);
+    bool flushBuffer();
+
+    QIODevice *device;
+    TraceFormat format;
+    QByteArray buffer;
+    bool headerWritten;
+    bool finished;
+    quint64 baseTimestampNs;
+};
+
+// Converts between trace formats. Parsing runs on a separate thread and hands
+// fixed-size chunks to the writer through a bounded queue, so conversion is
+// pipelined and runs in constant memory regardless of the capture size.
+class TraceConverter
+{
+public:
+    // Stops early, failing with "Cancelled", once *cancel is set
+    static bool convert(const QString &inputPath, const QString &outputPath, QString *error = nullptr,
+                        const std::atomic<bool> *cancel = nullptr);
+};
+
+#endif // TRACEIO_H
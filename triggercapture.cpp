@@ -0,0 +1,295 @@
+#include "triggercapture.h"
+#include "captureclock.h"
+#include "traceio.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSharedPointer>
+#include <QThread>
+#include <QTimer>
+
+#include <cstring>
+#include <utility>
+
+TriggerCapture::TriggerCapture(QObject *parent)
+    : QObject(parent)
+    , currentState(State::Idle)
+    , ringHead(0)
+    , ringSize(0)
+    , preNs(0)
+    , windowCapacity(0)
+    , postNs(0)
+    , windowEndNs(0)
+    , postTimer(new QTimer(this))
+    , pendingSaves(0)
+{
+    postTimer->setSingleShot(true);
+    connect(postTimer, &QTimer::timeout, this, &TriggerCapture::finishRecording);
+}
+
+// -------------------- CONDITIONS --------------------
+bool TriggerCapture::parseConditions(const QString &text, QVector<Condition> *result, QString *error)
+{
+    static const QRegularExpression byteTerm("^b([0-7])(?:&(\\w+))?=(\\w+)$",
+                                             QRegularExpression::CaseInsensitiveOption);
+
+    auto fail = [error](const QString &message) {
+        if (error)
+            *error = message;
+        return false;
+    };
+
+    QVector<Condition> parsed;
+    const QStringList clauses = text.split(';', Qt::SkipEmptyParts);
+    for (const QString &clause : clauses) {
+        const QStringList tokens = clause.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        if (tokens.isEmpty())
+            continue;
+
+        Condition condition;
+        uchar mask[8] = {};
+        uchar value[8] = {};
+        bool idMaskGiven = false;
+
+        for (int i = 0; i < tokens.size(); i++) {
+            const QString token = tokens[i].toLower();
+            bool ok = false;
+
+            if (token == "id" || token == "mask") {
+                if (i + 1 >= tokens.size())
+                    return fail(QString("Missing value after '%1'").arg(token));
+                quint32 number = tokens[++i].toUInt(&ok, 0);
+                if (!ok || number > 0x1FFFFFFF)
+                    return fail(QString("Invalid %1 '%2'").arg(token, tokens[i]));
+                if (token == "id") {
+                    condition.id = number;
+                    if (!idMaskGiven)
+                        condition.idMask = 0x1FFFFFFF;
+                } else {
+                    condition.idMask = number;
+                    idMaskGiven = true;
+                }
+                continue;
+            }
+
+            QRegularExpressionMatch match = byteTerm.match(token);
+            if (!match.hasMatch())
+                return fail(QString("Unknown term '%1'").arg(tokens[i]));
+
+            const int index = match.captured(1).toInt();
+            uint byteMask = 0xFF;
+            if (!match.captured(2).isEmpty()) {
+                byteMask = match.captured(2).toUInt(&ok, 0);
+                if (!ok || byteMask > 0xFF)
+                    return fail(QString("Invalid byte mask in '%1'").arg(tokens[i]));
+            }
+            const uint byteValue = match.captured(3).toUInt(&ok, 0);
+            if (!ok || byteValue > 0xFF)
+                return fail(QString("Invalid byte value in '%1'").arg(tokens[i]));
+
+            mask[index] = uchar(byteMask);
+            value[index] = uchar(byteValue & byteMask);
+            condition.minDlc = qMax<quint8>(condition.minDlc, quint8(index + 1));
+        }
+
+        condition.id &= condition.idMask;
+        memcpy(&condition.dataMask, mask, 8);
+        memcpy(&condition.dataValue, value, 8);
+        parsed.append(condition);
+    }
+
+    if (parsed.isEmpty())
+        return fail("No trigger condition given");
+
+    *result = parsed;
+    return true;
+}
+
+bool TriggerCapture::matches(const CanMessage &msg) const
+{
+    quint64 data;
+    memcpy(&data, msg.data, 8);
+
+    for (const Condition &condition : conditions) {
+        if ((msg.id & condition.idMask) == condition.id
+            && msg.dlc >= condition.minDlc
+            && (data & condition.dataMask) == condition.dataValue)
+            return true;
+    }
+    return false;
+}
+
+// -------------------- ARM / DISARM --------------------
+bool TriggerCapture::arm(const QString &text, double preSeconds, double postSeconds,
+                         const QString &directory, QString *error)
+{
+    QVector<Condition> parsed;
+    if (!parseConditions(text, &parsed, error))
+        return false;
+
+    if (!QDir(directory).exists()) {
+        if (error)
+            *error = "Output directory does not exist: " + directory;
+        return false;
+    }
+
+    conditions = parsed;
+    outputDirectory = directory;
+    preNs = quint64(qMax(preSeconds, 0.0) * 1e9);
+    postNs = quint64(qMax(postSeconds, 0.0) * 1e9);
+
+    // Everything the ingest path touches is sized here
+    const size_t ringCapacity = size_t(qMax(preSeconds, 0.1) * kMaxFrameRate);
+    ring.assign(ringCapacity, CanMessage());
+    ringHead = 0;
+    ringSize = 0;
+
+    windowCapacity = int(ringCapacity + size_t(qMax(postSeconds, 0.1) * kMaxFrameRate));
+    window = QVector<CanMessage>();
+    window.reserve(windowCapacity);
+    spareWindows.clear();
+    spareWindows.reserve(2);
+    spareWindows.append(QVector<CanMessage>());
+    spareWindows.last().reserve(windowCapacity);
+    finishedWindows.reserve(4);
+
+    currentState = State::Armed;
+    emit stateChanged();
+    return true;
+}
+
+void TriggerCapture::disarm()
+{
+    if (currentState == State::Recording)
+        finishRecording();
+
+    currentState = State::Idle;
+    ring.clear();
+    ring.shrink_to_fit();
+    window = QVector<CanMessage>();
+    spareWindows.clear();           // Captures not yet written are kept
+    emit stateChanged();
+}
+
+// -------------------- INGEST --------------------
+void TriggerCapture::onFrames(const QVector<CanMessage> &frames)
+{
+    if (currentState == State::Idle)
+        return;
+
+    for (const CanMessage &msg : frames) {
+        ring[ringHead] = msg;
+        ringHead = (ringHead + 1) % ring.size();
+        if (ringSize < ring.size())
+            ringSize++;
+
+        if (currentState == State::Recording) {
+            if (msg.timestampNs >= windowEndNs) {
+                finishRecording();
+            } else {
+                window.append(msg);
+                if (window.size() >= windowCapacity)
+                    finishRecording();
+                continue;
+            }
+        }
+
+        if (currentState == State::Armed && matches(msg))
+            fire(msg);
+    }
+}
+
+void TriggerCapture::fire(const CanMessage &msg)
+{
+    // Oldest ring entry first, limited to the pre-trigger window
+    const quint64 startNs = msg.timestampNs > preNs ? msg.timestampNs - preNs : 0;
+    size_t index = (ringHead + ring.size() - ringSize) % ring.size();
+    for (size_t i = 0; i < ringSize; i++) {
+        const CanMessage &buffered = ring[index];
+        if (buffered.timestampNs >= startNs)
+            window.append(buffered);
+        index = (index + 1) % ring.size();
+    }
+
+    windowEndNs = msg.timestampNs + postNs;
+    currentState = State::Recording;
+    postTimer->start(int(postNs / 1000000) + 100);
+
+    emit triggered(msg);
+    emit stateChanged();
+}
+
+// -------------------- SAVE --------------------
+void TriggerCapture::finishRecording()
+{
+    if (currentState != State::Recording)
+        return;
+
+    postTimer->stop();
+
+    // Hand the capture over and continue in a spare buffer, no copy
+    finishedWindows.append(QVector<CanMessage>());
+    finishedWindows.last().swap(window);
+    if (!spareWindows.isEmpty()) {
+        window.swap(spareWindows.last());
+        spareWindows.removeLast();
+    } else {
+        window.reserve(windowCapacity);     // Both buffers still being written
+    }
+    pendingSaves++;
+    currentState = State::Armed;
+    emit stateChanged();
+
+    // File name and worker thread are set up outside the ingest path
+    if (finishedWindows.size() == 1)
+        QMetaObject::invokeMethod(this, &TriggerCapture::saveCaptures, Qt::QueuedConnection);
+}
+
+void TriggerCapture::saveCaptures()
+{
+    const QString stamp = QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss-zzz");
+    for (int i = 0; i < finishedWindows.size(); i++) {
+        auto frames = QSharedPointer<QVector<CanMessage>>::create();
+        frames->swap(finishedWindows[i]);
+
+        // Captures finished within one event loop pass share the time stamp
+        const QString suffix = i > 0 ? QString("-%1").arg(i) : QString();
+        const QString path = QDir(outputDirectory).filePath("trigger-" + stamp + suffix + ".log");
+
+        // Disk I/O stays off the ingest thread
+        auto error = QSharedPointer<QString>::create();
+        QThread *worker = QThread::create([path, frames, error]() {
+            QFile file(path);
+            if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+                *error = file.errorString();
+                return;
+            }
+            TraceWriter writer(&file, TraceFormat::Candump);
+            for (CanMessage msg : std::as_const(*frames)) {
+                msg.timestampNs = CaptureClock::toEpochNs(msg.timestampNs);
+                writer.write(msg);
+            }
+            if (!writer.finish())
+                *error = file.errorString();
+        });
+        connect(worker, &QThread::finished, this, [this, worker, path, frames, error]() {
+            pendingSaves--;
+            if (error->isEmpty())
+                emit captureSaved(path, frames->size());
+            else
+                emit captureFailed(path + ": " + *error);
+
+            // Recycle the buffer while armed with the same window size, two at most
+            frames->resize(0);
+            if (currentState != State::Idle && frames->capacity() >= windowCapacity && spareWindows.isEmpty()) {
+                spareWindows.append(QVector<CanMessage>());
+                spareWindows.last().swap(*frames);
+            }
+            worker->deleteLater();
+        });
+        worker->start(QThread::LowPriority);
+    }
+    finishedWindows.clear();
+}
@@ -0,0 +1,100 @@
+#ifndef TRIGGERCAPTURE_H
+#define TRIGGERCAPTURE_H
+
+#include "canmessage.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+class QTimer;
+
+// Triggered capture: keeps the last N seconds of traffic in a fixed ring and,
+// when a frame matches one of the trigger conditions, saves the pre-trigger
+// window plus the following M seconds to a candump log.
+//
+// Conditions are separated by ';' and OR-ed together. Each one is a list of
+// terms that must all hold:
+//
+//   id 0x1900141 [mask 0x1FFFFFFF]   (id & mask) == (0x1900141 & mask)
+//   b3=0x40                          data[3] == 0x40
+//   b3&0xF0=0x40                     (data[3] & 0xF0) == 0x40
+//
+// e.g. "id 0x1900141 b0&0x80=0x80; id 0x7DF".
+//
+// Conditions compile to an ID mask/value and a 64-bit payload mask/value, so
+// evaluating a frame is a few compares. The ring and two window buffers are
+// allocated when arming: a finished capture swaps in the spare buffer and the
+// file is written on a worker thread queued from the event loop, so the
+// ingest path never allocates. The buffer goes back to the spares once its
+// file is written; only a capture finishing while every buffer is still
+// being written allocates a new one.
+class TriggerCapture : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Condition {
+        quint32 id = 0;
+        quint32 idMask = 0;         // 0 = any ID
+        quint64 dataValue = 0;      // In payload memory order
+        quint64 dataMask = 0;
+        quint8 minDlc = 0;          // Highest tested byte + 1
+    };
+
+    enum class State { Idle, Armed, Recording };
+
+    static const int kMaxFrameRate = 10000;    // Frames/s budgeted per second of window
+
+    explicit TriggerCapture(QObject *parent = nullptr);
+
+    static bool parseConditions(const QString &text, QVector<Condition> *conditions,
+                                QString *error = nullptr);
+
+    bool arm(const QString &conditions, double preSeconds, double postSeconds,
+             const QString &directory, QString *error = nullptr);
+    void disarm();
+
+    State state() const { return currentState; }
+    int savesInProgress() const { return pendingSaves; }
+
+public slots:
+    void onFrames(const QVector<CanMessage> &frames);   // called from the ingest path
+
+signals:
+    void triggered(const CanMessage &frame);
+    void captureSaved(const QString &path, int frames);
+    void captureFailed(const QString &error);
+    void stateChanged();
+
+private:
+    bool matches(const CanMessage &msg) const;
+    void fire(const CanMessage &msg);
+    void finishRecording();
+    void saveCaptures();             // Queued from finishRecording()
+
+    QVector<Condition> conditions;
+    State currentState;
+
+    // Pre-trigger ring
+    std::vector<CanMessage> ring;
+    size_t ringHead;                 // Next slot to write
+    size_t ringSize;
+    quint64 preNs;
+
+    // Post-trigger window
+    QVector<CanMessage> window;      // Pre + post frames of the running capture
+    QVector<QVector<CanMessage>> spareWindows;      // Empty, windowCapacity reserved
+    QVector<QVector<CanMessage>> finishedWindows;   // Waiting for saveCaptures()
+    int windowCapacity;
+    quint64 postNs;
+    quint64 windowEndNs;
+
+    QString outputDirectory;
+    QTimer *postTimer;               // Ends the window on a quiet bus
+    int pendingSaves;
+};
+
+#endif // TRIGGERCAPTURE_H
@@ -0,0 +1,74 @@
+#include "workstealingpool.h"
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : nextQueue(0)
+{
+    if (threads <= 0)
+        threads = int(std::thread::hardware_concurrency());
+    if (threads <= 0)
+        threads = 1;
+
+    for (int i = 0; i < threads; i++)
+        queues.push_back(std::make_unique<Queue>());
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+}
+
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    Queue &queue = *queues[size_t(nextQueue)];
+    nextQueue = (nextQueue + 1) % threadCount();
+
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+}
+
+bool WorkStealingPool::popLocal(int worker, std::function<void()> &task)
+{
+    Queue &queue = *queues[size_t(worker)];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(int thief, std::function<void()> &task)
+{
+    for (int offset = 1; offset < threadCount(); offset++) {
+        Queue &victim = *queues[size_t((thief + offset) % threadCount())];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+    std::function<void()> task;
+    // No tasks are added while running, so once every deque is empty this
+    // worker has nothing left to do
+    while (popLocal(worker, task) || steal(worker, task)) {
+        task();
+        task = nullptr;
+    }
+}
+
+void WorkStealingPool::run()
+{
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount(); i++)
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+
+    workerLoop(0); // The calling thread works too
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
@@ -0,0 +1,43 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker. Workers take tasks
+// from the back of their own deque and steal from the front of the others
+// once it runs dry, which keeps all cores busy when task costs are uneven
+// (e.g. capture chunks with very different frame densities).
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(int threads = 0); // 0 = hardware concurrency
+    ~WorkStealingPool();
+
+    int threadCount() const { return int(queues.size()); }
+
+    // Tasks are spread round-robin; must be called before run()
+    void submit(std::function<void()> task);
+
+    // Runs every submitted task to completion, blocking the caller
+    void run();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool popLocal(int worker, std::function<void()> &task);
+    bool steal(int thief, std::function<void()> &task);
+    void workerLoop(int worker);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    int nextQueue;
+};
+
+#endif // WORKSTEALINGPOOL_H